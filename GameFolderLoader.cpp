@@ -0,0 +1,98 @@
+#include "GameFolderLoader.h"
+#include <QMetaObject>
+
+GameFolderLoader::GameFolderLoader(ScenarioTreeModel* model, QObject* parent)
+    : QObject(parent)
+      , model(model)
+{
+}
+
+GameFolderLoader::~GameFolderLoader()
+{
+    // 工作线程会向本对象投递通知，必须在析构之前结束
+    cancel();
+}
+
+void GameFolderLoader::cancel()
+{
+    if (worker.joinable())
+    {
+        worker.request_stop();
+        worker.join();
+    }
+    ++generation;
+    loading = false;
+
+    // 旧的工作线程已经结束，不会再追加文件；已投递的 flush 只会取到新一次加载的文件
+    std::lock_guard lock(pending_mutex);
+    pending.clear();
+    flush_posted = false;
+}
+
+void GameFolderLoader::load(const QString& path)
+{
+    cancel();
+    model->clear();
+    loading = true;
+
+    const auto current = generation;
+    worker = std::jthread([this, current, folder = path.toStdString()](const std::stop_token& stop) mutable
+    {
+        auto game = std::make_shared<DragonData::DragonGameObject>();
+        DragonData::ScanOptions options;
+        // 场景树只需要场景头部，场景在首次打开时才构建
+        options.mode = DragonData::LoadMode::Lazy;
+        options.stop = stop;
+        options.on_file = [this](const DragonData::ScenarioFile& file, const DragonData::ScanFileKind kind)
+        {
+            ScenarioTreeModel::FileEntry entry{
+                QString::fromStdWString(file.getPath().filename().wstring()), kind, {}, file.getImage()
+            };
+            for (size_t i = 0; i < file.getScenarios().size(); ++i)
+            {
+                const auto game_data = file.readGameData(i);
+                entry.scenarios << QStringLiteral("%1 %2").arg(game_data.getYear())
+                                                          .arg(QString::fromStdWString(game_data.getName()));
+            }
+            enqueue(std::move(entry));
+        };
+        options.on_progress = [this, current](const size_t done, const size_t total)
+        {
+            QMetaObject::invokeMethod(this, [this, current, done, total]
+            {
+                if (current == generation) emit progress(static_cast<int>(done), static_cast<int>(total));
+            }, Qt::QueuedConnection);
+        };
+
+        const bool ok = game->openGameFolder(folder, options);
+        QMetaObject::invokeMethod(this, [this, current, ok, game = std::move(game)]() mutable
+        {
+            if (current != generation) return;
+            flush();
+            if (ok) model->setGame(std::move(game));
+            loading = false;
+            emit finished(ok);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void GameFolderLoader::enqueue(ScenarioTreeModel::FileEntry entry)
+{
+    std::lock_guard lock(pending_mutex);
+    pending.append(std::move(entry));
+    // 界面线程处理前到达的文件合并到同一批
+    if (flush_posted) return;
+    flush_posted = true;
+    QMetaObject::invokeMethod(this, [this] { flush(); }, Qt::QueuedConnection);
+}
+
+void GameFolderLoader::flush()
+{
+    QList<ScenarioTreeModel::FileEntry> batch;
+    {
+        std::lock_guard lock(pending_mutex);
+        batch.swap(pending);
+        flush_posted = false;
+    }
+    model->appendFiles(std::move(batch));
+}
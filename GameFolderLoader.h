@@ -0,0 +1,45 @@
+#pragma once
+#include <QObject>
+#include <mutex>
+#include <thread>
+#include "ScenarioTreeModel.h"
+
+// 在工作线程中打开游戏文件夹，不阻塞界面线程。
+// 每个解析完成的文件只读取场景头部，汇总后按批追加到模型；加载完成后把 DragonGameObject 绑定到模型。
+class GameFolderLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameFolderLoader(ScenarioTreeModel* model, QObject* parent = nullptr);
+    ~GameFolderLoader() override;
+
+    // 取消正在进行的加载并清空模型，然后开始加载 path，立即返回
+    void load(const QString& path);
+
+    // 等待工作线程中正在解析的文件完成，尚未开始的文件不再解析
+    void cancel();
+
+    [[nodiscard]] bool isLoading() const
+    {
+        return loading;
+    }
+
+signals:
+    void progress(int done, int total);
+    void finished(bool ok);
+
+private:
+    void enqueue(ScenarioTreeModel::FileEntry entry);
+    void flush();
+
+    ScenarioTreeModel* model;
+    std::jthread worker;
+    // 每次加载加 1，之前的加载投递到界面线程的通知据此丢弃
+    quint64 generation = 0;
+    bool loading = false;
+
+    std::mutex pending_mutex;
+    QList<ScenarioTreeModel::FileEntry> pending;
+    bool flush_posted = false;
+};
@@ -1,6 +1,9 @@
 #include "MainWindow.h"
 #include "ui_mainwindow.h"
 #include "SettingsDialog.h"
+#include "GameFolderLoader.h"
+#include "ScenarioTreeModel.h"
+#include <QDir>
 #include <QFileDialog>
 #include <QMessageBox>
 
@@ -8,21 +11,39 @@ MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
       , ui(new Ui::MainWindow)
       , settings("hlhtddx.net", "DragonEditor")
+      , scenarioModel(new ScenarioTreeModel(this))
+      , loader(new GameFolderLoader(scenarioModel, this))
 {
-    gameFolderPath = settings.value("gameFolderPath", "").toString();
-    if (!openGameFolderPath(gameFolderPath))
+    ui->setupUi(this);
+    ui->scenarioFileView->setModel(scenarioModel);
+    // 行高一致时视图不必逐行测量，数万行也能流畅滚动
+    ui->scenarioFileView->setUniformRowHeights(true);
+    connect(loader, &GameFolderLoader::progress, this, [this](const int done, const int total)
+    {
+        ui->statusbar->showMessage(tr("Loading %1/%2").arg(done).arg(total));
+    });
+    connect(loader, &GameFolderLoader::finished, this, [this](const bool ok)
+    {
+        ui->statusbar->showMessage(ok ? tr("Game folder loaded.") : tr("Failed to load game folder."), 3000);
+    });
+
+    const auto savedPath = settings.value("gameFolderPath", "").toString();
+    if (openGameFolderPath(savedPath))
+    {
+        gameFolderPath = savedPath;
+    }
+    else
     {
         qDebug() << "Invalid game folder path.";
-        gameFolderPath.clear();
     }
 
     dosboxExePath = settings.value("dosboxExePath", "").toString();
-    ui->setupUi(this);
     ui->actionLaunch->setDisabled(gameFolderPath.isEmpty() || dosboxExePath.isEmpty());
 }
 
 MainWindow::~MainWindow()
 {
+    loader->cancel();
     delete ui;
 }
 
@@ -79,7 +100,7 @@ void MainWindow::on_actionLaunch_triggered()
     QMessageBox::information(this, "Information", "Game launched successfully.");
 }
 
-bool MainWindow::openGameFolderPath(const QString& path) const
+bool MainWindow::openGameFolderPath(const QString& path)
 {
     if (path.isEmpty())
     {
@@ -89,5 +110,10 @@ bool MainWindow::openGameFolderPath(const QString& path) const
     {
         return false;
     }
+    if (!QDir(path).exists())
+    {
+        return false;
+    }
+    loader->load(path);
     return true;
 }
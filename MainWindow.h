@@ -4,6 +4,9 @@
 #include <QMainWindow>
 #include <QSettings>
 
+class GameFolderLoader;
+class ScenarioTreeModel;
+
 QT_BEGIN_NAMESPACE
 
 namespace Ui
@@ -32,8 +35,11 @@ private:
     QSettings settings;
     QString gameFolderPath;
     QString dosboxExePath;
+    ScenarioTreeModel* scenarioModel;
+    GameFolderLoader* loader;
 
-    bool openGameFolderPath(const QString& path) const;
+    // 在后台开始加载 path，立即返回；路径无效时返回 false
+    bool openGameFolderPath(const QString& path);
 
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,301 @@
+#include "ScenarioTreeModel.h"
+#include "NameTable.h"
+#include "RawLayout.h"
+#include "ScenarioDiff.h"
+#include <algorithm>
+
+using DragonData::BlockKind;
+namespace Raw = DragonData::Raw;
+
+namespace
+{
+// 每次 fetchMore 追加的行数
+constexpr int FILE_BATCH = 256;
+constexpr int SLOT_BATCH = 64;
+
+constexpr BlockKind CATEGORIES[] = {BlockKind::Forces, BlockKind::Cities, BlockKind::Characters, BlockKind::Legions};
+constexpr int CATEGORY_COUNT = static_cast<int>(std::size(CATEGORIES));
+
+static_assert(sizeof(quintptr) >= 8, "node ids need 64-bit internalId");
+static_assert(Raw::SCENARIO_COUNT <= 4 && CATEGORY_COUNT <= 4);
+
+enum Level : quintptr
+{
+    FileLevel = 0,
+    ScenarioLevel = 1,
+    CategoryLevel = 2,
+    SlotLevel = 3,
+};
+
+// internalId 编码节点自身：位 0-1 为层级，2-3 为场景，4-5 为分类，6-13 为槽位，14 及以上为文件行号
+quintptr node_id(const Level level, const quintptr file, const quintptr scenario = 0, const quintptr category = 0,
+                 const quintptr slot = 0)
+{
+    return level | scenario << 2 | category << 4 | slot << 6 | file << 14;
+}
+
+struct Node
+{
+    Level level;
+    int file;
+    int scenario;
+    int category;
+    uint8_t slot;
+
+    explicit Node(const QModelIndex& index)
+    {
+        const auto id = index.internalId();
+        level = static_cast<Level>(id & 3);
+        scenario = static_cast<int>(id >> 2 & 3);
+        category = static_cast<int>(id >> 4 & 3);
+        slot = static_cast<uint8_t>(id >> 6);
+        file = static_cast<int>(id >> 14);
+    }
+};
+
+QString raw_name(const Raw::Name& name)
+{
+    return QString::fromStdWString(DragonData::intern_name(name.name, sizeof(name.name)));
+}
+
+// 势力和军团没有自己的名字，显示君主和军团长
+QString slot_text(const Raw::Scenario& raw, const BlockKind kind, const uint8_t slot)
+{
+    const auto character = [&raw](const uint8_t index)
+    {
+        return index < DragonData::MAX_CHARACTERS ? raw_name(raw.characters[index].name) : QString();
+    };
+    QString name;
+    switch (kind)
+    {
+    case BlockKind::Forces:
+        name = character(raw.forces[slot].warlord);
+        break;
+    case BlockKind::Cities:
+        name = raw_name(raw.cities[slot].name);
+        break;
+    case BlockKind::Characters:
+        name = raw_name(raw.characters[slot].name);
+        break;
+    case BlockKind::Legions:
+        name = character(raw.legions[slot].leader);
+        break;
+    default:
+        break;
+    }
+    return QStringLiteral("%1 %2").arg(slot).arg(name);
+}
+}
+
+ScenarioTreeModel::ScenarioTreeModel(QObject* parent)
+    : QAbstractItemModel(parent)
+{
+}
+
+void ScenarioTreeModel::clear()
+{
+    beginResetModel();
+    files.clear();
+    fetched_files = 0;
+    category_slots.clear();
+    game.reset();
+    endResetModel();
+}
+
+void ScenarioTreeModel::appendFiles(QList<FileEntry> entries)
+{
+    if (entries.isEmpty()) return;
+    files.append(std::move(entries));
+    // 第一批直接显示，其余等视图滚动到末尾时再取
+    if (fetched_files < FILE_BATCH) fetchMore({});
+}
+
+void ScenarioTreeModel::setGame(std::shared_ptr<const DragonData::DragonGameObject> value)
+{
+    game = std::move(value);
+}
+
+const DragonData::ScenarioFile* ScenarioTreeModel::fileAt(int row) const
+{
+    if (!game || row < 0) return nullptr;
+    const auto& scenario_files = game->get_scenario_files();
+    if (row < static_cast<int>(scenario_files.size())) return &scenario_files[row];
+    row -= static_cast<int>(scenario_files.size());
+    const auto& saved_files = game->get_saved_files();
+    if (row < static_cast<int>(saved_files.size())) return &saved_files[row];
+    row -= static_cast<int>(saved_files.size());
+    if (row == 0 && game->get_default_saved_file().getImage()) return &game->get_default_saved_file();
+    return nullptr;
+}
+
+const ScenarioTreeModel::CategoryRows* ScenarioTreeModel::rowsOf(const quintptr category) const
+{
+    const auto it = category_slots.constFind(category);
+    return it == category_slots.cend() ? nullptr : &*it;
+}
+
+QModelIndex ScenarioTreeModel::index(const int row, const int column, const QModelIndex& parent) const
+{
+    if (!hasIndex(row, column, parent)) return {};
+    if (!parent.isValid()) return createIndex(row, column, node_id(FileLevel, row));
+    const Node node(parent);
+    switch (node.level)
+    {
+    case FileLevel:
+        return createIndex(row, column, node_id(ScenarioLevel, node.file, row));
+    case ScenarioLevel:
+        return createIndex(row, column, node_id(CategoryLevel, node.file, node.scenario, row));
+    case CategoryLevel:
+        return createIndex(row, column, node_id(SlotLevel, node.file, node.scenario, node.category,
+                                                rowsOf(parent.internalId())->occupied[row]));
+    default:
+        return {};
+    }
+}
+
+QModelIndex ScenarioTreeModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid()) return {};
+    const Node node(child);
+    switch (node.level)
+    {
+    case ScenarioLevel:
+        return createIndex(node.file, 0, node_id(FileLevel, node.file));
+    case CategoryLevel:
+        return createIndex(node.scenario, 0, node_id(ScenarioLevel, node.file, node.scenario));
+    case SlotLevel:
+        return createIndex(node.category, 0, node_id(CategoryLevel, node.file, node.scenario, node.category));
+    default:
+        return {};
+    }
+}
+
+int ScenarioTreeModel::rowCount(const QModelIndex& parent) const
+{
+    if (!parent.isValid()) return fetched_files;
+    if (parent.column() != 0) return 0;
+    const Node node(parent);
+    switch (node.level)
+    {
+    case FileLevel:
+        return static_cast<int>(files[node.file].scenarios.size());
+    case ScenarioLevel:
+        return CATEGORY_COUNT;
+    case CategoryLevel:
+    {
+        const auto* rows = rowsOf(parent.internalId());
+        return rows ? rows->fetched : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+int ScenarioTreeModel::columnCount(const QModelIndex&) const
+{
+    return 1;
+}
+
+bool ScenarioTreeModel::hasChildren(const QModelIndex& parent) const
+{
+    if (!parent.isValid() || parent.column() != 0) return QAbstractItemModel::hasChildren(parent);
+    const Node node(parent);
+    if (node.level == SlotLevel) return false;
+    if (node.level != CategoryLevel) return QAbstractItemModel::hasChildren(parent);
+    // 尚未扫描的分类先显示展开标记，展开时由 fetchMore 扫描
+    const auto* rows = rowsOf(parent.internalId());
+    return !rows || !rows->occupied.empty();
+}
+
+bool ScenarioTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (!parent.isValid()) return fetched_files < static_cast<int>(files.size());
+    if (parent.column() != 0 || Node(parent).level != CategoryLevel) return false;
+    const auto* rows = rowsOf(parent.internalId());
+    return !rows || rows->fetched < static_cast<int>(rows->occupied.size());
+}
+
+void ScenarioTreeModel::fetchMore(const QModelIndex& parent)
+{
+    if (!parent.isValid())
+    {
+        const int count = std::min(FILE_BATCH, static_cast<int>(files.size()) - fetched_files);
+        if (count <= 0) return;
+        beginInsertRows({}, fetched_files, fetched_files + count - 1);
+        fetched_files += count;
+        endInsertRows();
+        return;
+    }
+    if (parent.column() != 0) return;
+    const Node node(parent);
+    if (node.level != CategoryLevel) return;
+
+    const auto id = parent.internalId();
+    if (!category_slots.contains(id))
+    {
+        CategoryRows scanned;
+        const auto kind = CATEGORIES[node.category];
+        const auto block = block_span(files[node.file].image->getScenario(node.scenario), kind);
+        const auto size = DragonData::record_size(kind);
+        for (size_t slot = 0; slot < DragonData::record_count(kind); ++slot)
+        {
+            if (is_record_occupied(kind, block.data + slot * size)) scanned.occupied.push_back(static_cast<uint8_t>(slot));
+        }
+        category_slots.insert(id, std::move(scanned));
+    }
+
+    auto& rows = category_slots[id];
+    const int count = std::min(SLOT_BATCH, static_cast<int>(rows.occupied.size()) - rows.fetched);
+    if (count <= 0) return;
+    beginInsertRows(parent, rows.fetched, rows.fetched + count - 1);
+    rows.fetched += count;
+    endInsertRows();
+}
+
+QVariant ScenarioTreeModel::data(const QModelIndex& index, const int role) const
+{
+    if (!index.isValid()) return {};
+    const Node node(index);
+    if (node.level == SlotLevel)
+    {
+        const auto kind = CATEGORIES[node.category];
+        switch (role)
+        {
+        case Qt::DisplayRole:
+            return slot_text(files[node.file].image->getScenario(node.scenario), kind, node.slot);
+        case SlotRole:
+            return static_cast<int>(node.slot);
+        case KindRole:
+            return static_cast<int>(kind);
+        default:
+            return {};
+        }
+    }
+
+    if (role != Qt::DisplayRole) return {};
+    switch (node.level)
+    {
+    case FileLevel:
+        return files[node.file].name;
+    case ScenarioLevel:
+        return files[node.file].scenarios[node.scenario];
+    default:
+        switch (CATEGORIES[node.category])
+        {
+        case BlockKind::Forces:
+            return tr("Forces");
+        case BlockKind::Cities:
+            return tr("Cities");
+        case BlockKind::Characters:
+            return tr("Characters");
+        default:
+            return tr("Legions");
+        }
+    }
+}
+
+QVariant ScenarioTreeModel::headerData(const int section, const Qt::Orientation orientation, const int role) const
+{
+    if (section == 0 && orientation == Qt::Horizontal && role == Qt::DisplayRole) return tr("Scenario");
+    return {};
+}
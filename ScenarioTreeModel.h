@@ -0,0 +1,73 @@
+#pragma once
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QStringList>
+#include <memory>
+#include <vector>
+#include "DragonData.h"
+#include "BlockIndex.h"
+
+// 场景树：文件（场景文件、存档、SAVE.DAT）→ 场景 → 分类（势力、城市、人物、军团）→ 实体。
+// 加载过程中按批追加文件；加载完成后绑定 DragonGameObject，行号与其中文件的顺序一致。
+// 文件和实体行通过 canFetchMore/fetchMore 分批出现，实体行直接读取文件映像中的原始记录，
+// 不构建 Scenario，也不为每个实体创建条目。
+class ScenarioTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    struct FileEntry
+    {
+        QString name;
+        DragonData::ScanFileKind kind;
+        QStringList scenarios;
+        DragonData::RawFileImagePtr image;
+    };
+
+    // 实体行在 SlotRole 下返回原始槽位，在 KindRole 下返回 BlockKind
+    enum Role
+    {
+        SlotRole = Qt::UserRole,
+        KindRole,
+    };
+
+    explicit ScenarioTreeModel(QObject* parent = nullptr);
+
+    void clear();
+    void appendFiles(QList<FileEntry> entries);
+    void setGame(std::shared_ptr<const DragonData::DragonGameObject> value);
+
+    [[nodiscard]] const std::shared_ptr<const DragonData::DragonGameObject>& getGame() const
+    {
+        return game;
+    }
+
+    // 第 row 个文件；尚未绑定 DragonGameObject 或超出范围时返回 nullptr
+    [[nodiscard]] const DragonData::ScenarioFile* fileAt(int row) const;
+
+    [[nodiscard]] QModelIndex index(int row, int column, const QModelIndex& parent = {}) const override;
+    [[nodiscard]] QModelIndex parent(const QModelIndex& child) const override;
+    [[nodiscard]] int rowCount(const QModelIndex& parent = {}) const override;
+    [[nodiscard]] int columnCount(const QModelIndex& parent = {}) const override;
+    [[nodiscard]] bool hasChildren(const QModelIndex& parent = {}) const override;
+    [[nodiscard]] bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation,
+                                      int role = Qt::DisplayRole) const override;
+
+private:
+    // 分类下已占用的槽位，首次展开时扫描一次
+    struct CategoryRows
+    {
+        std::vector<uint8_t> occupied;
+        int fetched = 0;
+    };
+
+    [[nodiscard]] const CategoryRows* rowsOf(quintptr category) const;
+
+    QList<FileEntry> files;
+    int fetched_files = 0;
+    QHash<quintptr, CategoryRows> category_slots;
+    std::shared_ptr<const DragonData::DragonGameObject> game;
+};
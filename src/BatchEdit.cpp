@@ -0,0 +1,200 @@
+#include "BatchEdit.h"
+#include "Parallel.h"
+#include "RawFileImage.h"
+#include "ScenarioValidator.h"
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    int64_t field_max(const FieldInfo& field)
+    {
+        return (int64_t{1} << field_width(field.type) * 8) - 1;
+    }
+
+    vector<string_view> split_words(const string_view text)
+    {
+        vector<string_view> words;
+        size_t i = 0;
+        while (true)
+        {
+            i = text.find_first_not_of(" \t\r", i);
+            if (i == string_view::npos) break;
+            const auto end = min(text.find_first_of(" \t\r", i), text.size());
+            words.push_back(text.substr(i, end - i));
+            i = end;
+        }
+        return words;
+    }
+
+    int64_t parse_number(const string_view text)
+    {
+        int64_t value = 0;
+        const auto* begin = text.data() + (text.starts_with('+') ? 1 : 0);
+        const auto [end, ec] = from_chars(begin, text.data() + text.size(), value);
+        if (ec != errc() || end != text.data() + text.size() || begin == end)
+        {
+            throw invalid_argument("invalid number: " + string(text));
+        }
+        return value;
+    }
+
+    EditAction parse_action(const string_view text)
+    {
+        if (text == "set") return EditAction::Set;
+        if (text == "add") return EditAction::Add;
+        if (text == "cap") return EditAction::Cap;
+        if (text == "floor") return EditAction::Floor;
+        throw invalid_argument("unknown action: " + string(text));
+    }
+}
+
+EditRule::EditRule(const BlockKind table, const string_view field, const EditAction action, const int64_t value)
+    : filter(table), target(find_field(table, field)), action(action), value(value)
+{
+    if (target.field->type == FieldType::Name) throw invalid_argument("field is not numeric: " + string(field));
+    if (action != EditAction::Add && (value < 0 || value > field_max(*target.field)))
+    {
+        throw out_of_range("value does not fit field: " + string(field));
+    }
+}
+
+EditRule EditRule::parse(const string_view text)
+{
+    const auto words = split_words(text);
+    if (words.size() < 3) throw invalid_argument("incomplete rule: " + string(text));
+
+    const auto dot = words[1].find('.');
+    if (dot == string_view::npos) throw invalid_argument("expected <table>.<field>: " + string(words[1]));
+    EditRule rule(parse_table(words[1].substr(0, dot)), words[1].substr(dot + 1), parse_action(words[0]),
+                  parse_number(words[2]));
+
+    // where a op b and c op d ...
+    for (size_t i = 3; i < words.size(); i += 4)
+    {
+        if (words[i] != (i == 3 ? "where" : "and")) throw invalid_argument("unexpected: " + string(words[i]));
+        if (i + 3 >= words.size()) throw invalid_argument("incomplete condition: " + string(text));
+        rule.where(words[i + 1], parse_compare_op(words[i + 2]), parse_number(words[i + 3]));
+    }
+    return rule;
+}
+
+size_t EditRule::apply(Raw::Scenario& raw) const
+{
+    const auto table = getTable();
+    auto* block = reinterpret_cast<uint8_t*>(&raw) + block_offset(table);
+    const auto size = record_size(table);
+    const auto& field = *target.field;
+    size_t count = 0;
+    for (size_t slot = 0; slot < record_count(table); ++slot)
+    {
+        auto* record = block + slot * size;
+        if (!filter.matches(record)) continue;
+
+        const auto old_value = read_field(record + target.offset, field.type);
+        int64_t new_value = old_value;
+        switch (action)
+        {
+        case EditAction::Set:
+            new_value = value;
+            break;
+        case EditAction::Add:
+            new_value = clamp(old_value + value, int64_t{0}, field_max(field));
+            break;
+        case EditAction::Cap:
+            new_value = min(old_value, value);
+            break;
+        case EditAction::Floor:
+            new_value = max(old_value, value);
+            break;
+        }
+        if (new_value == old_value) continue;
+        write_field(record + target.offset, field.type, new_value);
+        ++count;
+    }
+    return count;
+}
+
+vector<EditRule> parse_edit_script(const string_view text)
+{
+    vector<EditRule> rules;
+    size_t line_number = 0;
+    for (size_t begin = 0; begin <= text.size();)
+    {
+        const auto end = min(text.find('\n', begin), text.size());
+        auto line = text.substr(begin, end - begin);
+        begin = end + 1;
+        ++line_number;
+
+        line = line.substr(0, line.find('#'));
+        if (split_words(line).empty()) continue;
+        try
+        {
+            rules.push_back(EditRule::parse(line));
+        }
+        catch (const exception& e)
+        {
+            throw invalid_argument("line " + to_string(line_number) + ": " + e.what());
+        }
+    }
+    return rules;
+}
+
+size_t BatchEdit::apply(Raw::File& file) const
+{
+    size_t count = 0;
+    for (auto& scenario : file.scenarios)
+    {
+        for (const auto& rule : rules)
+        {
+            count += rule.apply(scenario);
+        }
+    }
+    return count;
+}
+
+vector<BatchEditResult> BatchEdit::run(const vector<fs::path>& files, const BatchEditOptions& options) const
+{
+    vector<BatchEditResult> results(files.size());
+    auto edit = [&](const fs::path& path, BatchEditResult& result)
+    {
+        result.path = path;
+        try
+        {
+            const auto image = RawFileImage::open(path);
+            if (!image) throw runtime_error("invalid scenario file size: " + path.string());
+            if (!is_valid_file(image->getFile()))
+            {
+                throw runtime_error("scenario file failed validation: " + path.string());
+            }
+
+            const auto edited = make_unique<Raw::File>(image->getFile());
+            if (apply(*edited) == 0) return;
+            diff_files(image->getFile(), *edited, result.changes, options.diff);
+            // 规则可以改写关联字段，不写入按此构建对象会越界的结果
+            if (!is_valid_file(*edited))
+            {
+                throw runtime_error("edit rules produce an invalid scenario file: " + path.string());
+            }
+            if (options.dry_run) return;
+
+            replace_file_atomically(path, span(reinterpret_cast<const uint8_t*>(edited.get()), image->getFileSize()),
+                                    options.sync);
+            result.written = true;
+        }
+        catch (const exception& e)
+        {
+            result.error = e.what();
+        }
+    };
+
+    parallel_for(files.size(), options.threads, [&](const size_t i) { edit(files[i], results[i]); });
+    return results;
+}
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "Query.h"
+#include "ScenarioDiff.h"
+
+namespace DragonData
+{
+enum class EditAction : uint8_t
+{
+    Set = 0, // 设为 value
+    Add = 1, // 加上 value（可为负），结果限制在字段范围内
+    Cap = 2, // 不超过 value
+    Floor = 3, // 不低于 value
+};
+
+// 一条修改规则：对满足全部条件的每条记录修改一个数值字段。
+// 条件与 Query 相同，直接在 Raw 记录上求值，空槽位不会被修改。
+class EditRule
+{
+public:
+    // field 的写法与 Query::where 相同，表和字段的限制也相同，不符合时抛出 std::invalid_argument；
+    // Set、Cap、Floor 的 value 超出字段范围时抛出 std::out_of_range
+    EditRule(BlockKind table, string_view field, EditAction action, int64_t value);
+
+    EditRule& where(string_view field, CompareOp op, int64_t value)
+    {
+        filter.where(field, op, value);
+        return *this;
+    }
+
+    // 解析一行规则：
+    //   <set|add|cap|floor> <table>.<field> <value> [where <field> <op> <value> [and ...]]
+    // table 为 game_data、forces、cities、legions 或 characters，op 为 == != < <= > >=，各部分以空白分隔。
+    //   cap characters.command 100 where status == 0
+    // 格式错误时抛出 std::invalid_argument
+    static EditRule parse(string_view text);
+
+    [[nodiscard]] BlockKind getTable() const
+    {
+        return filter.getTable();
+    }
+
+    [[nodiscard]] const FieldInfo& getField() const
+    {
+        return *target.field;
+    }
+
+    [[nodiscard]] EditAction getAction() const
+    {
+        return action;
+    }
+
+    [[nodiscard]] int64_t getValue() const
+    {
+        return value;
+    }
+
+    // 修改 raw 中匹配的记录，返回值发生变化的记录数
+    size_t apply(Raw::Scenario& raw) const;
+
+private:
+    Query filter;
+    FieldRef target;
+    EditAction action;
+    int64_t value;
+};
+
+// 每行一条规则，忽略空行和 # 开头的注释；出错时抛出 std::invalid_argument，消息中带有行号
+vector<EditRule> parse_edit_script(string_view text);
+
+struct BatchEditOptions
+{
+    // 只计算并报告修改，不写入文件
+    bool dry_run = false;
+    // 为 false 时写入后不 fsync
+    bool sync = true;
+    // 并行处理文件的线程数，0 表示使用硬件并发数
+    size_t threads = 0;
+    DiffOptions diff;
+};
+
+struct BatchEditResult
+{
+    fs::path path;
+    vector<FieldChange> changes;
+    bool written = false; // 有修改且不是 dry_run 时为 true
+    string error; // 打开、校验或写入失败时的原因，此时文件保持不变
+};
+
+// 把一组规则按顺序应用到多个场景文件，后面的规则看到前面规则的结果。
+// 每个文件在修改前后都经过 is_valid_file 检查，先在内存中的副本上修改，再以 replace_file_atomically
+// 只写入变化的字节并原子地替换原文件，读者只会看到完整的旧文件或新文件。单个文件失败不影响其他文件。
+//
+//   BatchEdit()
+//       .add(EditRule(BlockKind::Forces, "money", EditAction::Set, 50000))
+//       .add(EditRule::parse("cap characters.command 100"))
+//       .run(paths, {.dry_run = true});
+class BatchEdit
+{
+public:
+    BatchEdit() = default;
+
+    explicit BatchEdit(vector<EditRule> rules)
+        : rules(std::move(rules))
+    {
+    }
+
+    BatchEdit& add(EditRule rule)
+    {
+        rules.push_back(std::move(rule));
+        return *this;
+    }
+
+    [[nodiscard]] const vector<EditRule>& getRules() const
+    {
+        return rules;
+    }
+
+    // 修改文件的全部场景，返回值发生变化的记录数（同一记录被多条规则修改时重复计数）
+    size_t apply(Raw::File& file) const;
+
+    // 并行处理 files，结果与 files 的顺序一致；同一文件不应出现两次
+    [[nodiscard]] vector<BatchEditResult> run(const vector<fs::path>& files, const BatchEditOptions& options = {}) const;
+
+private:
+    vector<EditRule> rules;
+};
+}
@@ -0,0 +1,146 @@
+#include "BatchEdit.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+TEST(BatchEdit, ParseRules)
+{
+    const auto rule = EditRule::parse("cap characters.command 60 where status == 0 and force_or_capture != 255");
+    EXPECT_EQ(rule.getTable(), BlockKind::Characters);
+    EXPECT_STREQ(rule.getField().name, "command");
+    EXPECT_EQ(rule.getAction(), EditAction::Cap);
+    EXPECT_EQ(rule.getValue(), 60);
+    EXPECT_EQ(EditRule::parse("add legions.troops.count[2] -10").getAction(), EditAction::Add);
+
+    EXPECT_THROW(EditRule::parse("set forces.money"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("raise forces.money 1"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("set friendship.value 1"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("set characters.name 1"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("set forces.money 1 where"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("set forces.money 1 when money > 0"), std::invalid_argument);
+    EXPECT_THROW(EditRule::parse("set characters.command 256"), std::out_of_range);
+
+    const auto rules = parse_edit_script("# 全部势力\nset forces.money 50000\n\ncap characters.command 100  # 上限\n");
+    ASSERT_EQ(rules.size(), 2);
+    EXPECT_EQ(rules[1].getValue(), 100);
+    try
+    {
+        (void)parse_edit_script("set forces.money 1\nset forces.gold 1\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_TRUE(std::string(e.what()).starts_with("line 2:")) << e.what();
+    }
+}
+
+TEST(BatchEdit, EditFiles)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto work_path = fs::temp_directory_path() / "BatchEdit_files";
+    fs::remove_all(work_path);
+    fs::create_directories(work_path);
+    std::vector<fs::path> files;
+    for (int i = 1; i <= 6; ++i)
+    {
+        auto name = "SINARIO-0" + std::to_string(i) + ".DAT";
+        fs::copy_file(data_path / name, work_path / name);
+        files.push_back(work_path / name);
+    }
+    fs::copy_file(data_path / "SAVE.DAT", work_path / "SAVE.DAT");
+    files.push_back(work_path / "SAVE.DAT");
+    std::ofstream(work_path / "BROKEN.DAT") << "not a scenario";
+    files.push_back(work_path / "BROKEN.DAT");
+
+    const BatchEdit edit(parse_edit_script("set forces.money 50000\ncap characters.command 60\n"));
+
+    // 试运行只报告修改
+    const auto original = RawFileImage::open(work_path / "SINARIO-01.DAT");
+    auto results = edit.run(files, {.dry_run = true, .threads = 3});
+    ASSERT_EQ(results.size(), files.size());
+    for (size_t i = 0; i + 1 < files.size(); ++i)
+    {
+        EXPECT_EQ(results[i].path, files[i]);
+        EXPECT_TRUE(results[i].error.empty()) << results[i].error;
+        EXPECT_FALSE(results[i].written);
+        EXPECT_FALSE(results[i].changes.empty());
+    }
+    EXPECT_FALSE(results.back().error.empty());
+    const auto& change = results[0].changes[0];
+    EXPECT_EQ(change.after, change.field->name == std::string_view("money") ? 50000 : 60);
+    EXPECT_EQ(fs::file_size(files[0]), fs::file_size(data_path / "SINARIO-01.DAT"));
+    EXPECT_EQ(std::memcmp(RawFileImage::open(files[0])->getData(), original->getData(), original->getFileSize()), 0);
+
+    results = edit.run(files, {.sync = false});
+    for (size_t i = 0; i + 1 < files.size(); ++i)
+    {
+        ASSERT_TRUE(results[i].written) << results[i].error;
+        // 截断的文件保持原来的长度
+        const auto before = RawFileImage::open(data_path / files[i].filename());
+        const auto after = RawFileImage::open(files[i]);
+        ASSERT_TRUE(after);
+        EXPECT_EQ(after->getFileSize(), before->getFileSize());
+
+        std::vector<FieldChange> changes;
+        diff_files(before->getFile(), after->getFile(), changes);
+        EXPECT_EQ(changes.size(), results[i].changes.size());
+        for (size_t s = 0; s < Raw::SCENARIO_COUNT; ++s)
+        {
+            const auto& scenario = after->getScenario(s);
+            const auto& previous = before->getScenario(s);
+            for (size_t slot = 0; slot < std::size(scenario.characters); ++slot)
+            {
+                const auto* record = reinterpret_cast<const uint8_t*>(&scenario.characters[slot]);
+                if (!is_record_occupied(BlockKind::Characters, record)) continue;
+                EXPECT_EQ(scenario.characters[slot].command, std::min<int>(previous.characters[slot].command, 60));
+            }
+        }
+    }
+
+    // 再次运行没有修改，不写入文件
+    const auto timestamp = fs::last_write_time(files[0]);
+    results = edit.run({files[0]});
+    EXPECT_TRUE(results[0].changes.empty());
+    EXPECT_FALSE(results[0].written);
+    EXPECT_EQ(fs::last_write_time(files[0]), timestamp);
+
+    fs::remove_all(work_path);
+}
+
+TEST(BatchEdit, RejectInvalidFiles)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto work_path = fs::temp_directory_path() / "BatchEdit_invalid";
+    fs::remove_all(work_path);
+    fs::create_directories(work_path);
+    const auto path = work_path / "SINARIO-01.DAT";
+    fs::copy_file(data_path / "SINARIO-01.DAT", path);
+    const auto original = RawFileImage::open(path);
+    ASSERT_TRUE(original);
+
+    // 规则让关联越界时不写入
+    auto results = BatchEdit(parse_edit_script("set forces.warlord 250\n")).run({path});
+    EXPECT_FALSE(results[0].written);
+    EXPECT_NE(results[0].error.find("invalid scenario file"), std::string::npos) << results[0].error;
+    EXPECT_EQ(std::memcmp(RawFileImage::open(path)->getData(), original->getData(), original->getFileSize()), 0);
+
+    // 已经损坏的文件在应用规则之前拒绝
+    auto raw = std::make_unique<Raw::File>(original->getFile());
+    for (auto& force : raw->scenarios[0].forces)
+    {
+        if (force.status != 0) force.warlord = 250;
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(raw.get()), static_cast<std::streamsize>(original->getFileSize()));
+    }
+    results = BatchEdit(parse_edit_script("set forces.money 1\n")).run({path}, {.dry_run = true});
+    EXPECT_TRUE(results[0].changes.empty());
+    EXPECT_NE(results[0].error.find("failed validation"), std::string::npos) << results[0].error;
+
+    fs::remove_all(work_path);
+}
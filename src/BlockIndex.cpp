@@ -0,0 +1,242 @@
+#include "BlockIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    constexpr uint64_t PRIME_1 = 0x9e3779b185ebca87ull;
+    constexpr uint64_t PRIME_2 = 0xc2b2ae3d27d4eb4full;
+
+    uint64_t rotl(const uint64_t x, const int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // 按小端序读取，保证不同平台上的哈希一致
+    uint64_t load_word(const uint8_t* p, const size_t n)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            value |= static_cast<uint64_t>(p[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= PRIME_2;
+        h ^= h >> 29;
+        h *= PRIME_1;
+        h ^= h >> 32;
+        return h;
+    }
+
+    bool same_block(const BlockIndex::Location& location, const BlockSpan& span, const BlockKind kind)
+    {
+        const auto other = block_span(location.image->getScenario(location.scenario), kind);
+        return memcmp(other.data, span.data, span.size) == 0;
+    }
+}
+
+uint64_t hash_bytes(const void* data, const size_t size)
+{
+    const auto* p = static_cast<const uint8_t*>(data);
+    uint64_t h = PRIME_1 ^ (size * PRIME_2);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            memcpy(&word, p + i, 8);
+        }
+        else
+        {
+            word = load_word(p + i, 8);
+        }
+        h = rotl(h ^ (word * PRIME_2), 31) * PRIME_1;
+    }
+    if (i < size)
+    {
+        h = rotl(h ^ (load_word(p + i, size - i) * PRIME_2), 31) * PRIME_1;
+    }
+    return mix(h);
+}
+
+BlockSpan block_span(const Raw::Scenario& raw, const BlockKind kind)
+{
+    const auto span = [](const auto& field)
+    {
+        return BlockSpan{reinterpret_cast<const uint8_t*>(&field), sizeof(field)};
+    };
+
+    switch (kind)
+    {
+    case BlockKind::Scenario:
+        return span(raw);
+    case BlockKind::GameData:
+        return span(raw.game_data);
+    case BlockKind::Forces:
+        return span(raw.forces);
+    case BlockKind::Friendship:
+        return span(raw.friendship);
+    case BlockKind::Cities:
+        return span(raw.cities);
+    case BlockKind::Legions:
+        return span(raw.legions);
+    case BlockKind::Characters:
+        return span(raw.characters);
+    }
+    throw invalid_argument("unknown block kind");
+}
+
+ScenarioHashes hash_scenario(const Raw::Scenario& raw)
+{
+    ScenarioHashes hashes;
+    for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+    {
+        const auto span = block_span(raw, static_cast<BlockKind>(kind));
+        hashes.blocks[kind] = hash_bytes(span.data, span.size);
+    }
+    return hashes;
+}
+
+void BlockIndex::add(const RawFileImagePtr& image)
+{
+    for (uint8_t scenario = 0; scenario < Raw::SCENARIO_COUNT; ++scenario)
+    {
+        const auto& raw = image->getScenario(scenario);
+        const auto hashes = hash_scenario(raw);
+        for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+        {
+            auto& table = tables[kind];
+            const auto span = block_span(raw, static_cast<BlockKind>(kind));
+            auto& groups = table.groups[hashes.blocks[kind]];
+            auto it = find_if(groups.begin(), groups.end(), [&](const Group& group)
+            {
+                return same_block(group.front(), span, static_cast<BlockKind>(kind));
+            });
+            if (it == groups.end())
+            {
+                it = groups.emplace(groups.end());
+                ++table.distinct;
+            }
+            it->push_back({image, scenario});
+            ++table.blocks;
+        }
+    }
+}
+
+void BlockIndex::remove(const RawFileImagePtr& image)
+{
+    for (auto& table : tables)
+    {
+        for (auto it = table.groups.begin(); it != table.groups.end();)
+        {
+            auto& groups = it->second;
+            for (auto group = groups.begin(); group != groups.end();)
+            {
+                table.blocks -= erase_if(*group, [&image](const Location& location)
+                {
+                    return location.image == image;
+                });
+                if (!group->empty())
+                {
+                    ++group;
+                    continue;
+                }
+                group = groups.erase(group);
+                --table.distinct;
+            }
+            it = groups.empty() ? table.groups.erase(it) : next(it);
+        }
+    }
+}
+
+void BlockIndex::clear()
+{
+    tables = {};
+}
+
+const BlockIndex::Group& BlockIndex::find(const Raw::Scenario& raw, const BlockKind kind) const
+{
+    static const Group empty;
+    const auto span = block_span(raw, kind);
+    const auto& groups = tables[static_cast<size_t>(kind)].groups;
+    const auto found = groups.find(hash_bytes(span.data, span.size));
+    if (found == groups.end()) return empty;
+    for (const auto& group : found->second)
+    {
+        if (same_block(group.front(), span, kind)) return group;
+    }
+    return empty;
+}
+
+size_t BlockIndex::blockCount(const BlockKind kind) const
+{
+    return tables[static_cast<size_t>(kind)].blocks;
+}
+
+size_t BlockIndex::distinctCount(const BlockKind kind) const
+{
+    return tables[static_cast<size_t>(kind)].distinct;
+}
+
+shared_ptr<const Scenario> ScenarioPool::find(const uint64_t hash, const Raw::Scenario& raw)
+{
+    const auto [first, last] = entries.equal_range(hash);
+    for (auto it = first; it != last;)
+    {
+        const auto entry = it->second.lock();
+        if (!entry)
+        {
+            it = entries.erase(it);
+            continue;
+        }
+        if (memcmp(&entry->image->getScenario(entry->index), &raw, sizeof(raw)) == 0)
+        {
+            return {entry, &entry->scenario};
+        }
+        ++it;
+    }
+    return nullptr;
+}
+
+shared_ptr<const Scenario> ScenarioPool::acquire(const RawFileImagePtr& image, const size_t index)
+{
+    const auto& raw = image->getScenario(index);
+    const auto hash = hash_bytes(&raw, sizeof(raw));
+    {
+        lock_guard lock(mutex);
+        if (auto found = find(hash, raw)) return found;
+    }
+
+    // 在锁外构建，其它线程可以同时构建不同的场景
+    auto entry = make_shared<const Entry>(image, index);
+
+    lock_guard lock(mutex);
+    if (auto found = find(hash, raw)) return found;
+    entries.emplace(hash, entry);
+    return {entry, &entry->scenario};
+}
+
+size_t ScenarioPool::size() const
+{
+    lock_guard lock(mutex);
+    size_t count = 0;
+    for (const auto& [hash, entry] : entries)
+    {
+        count += !entry.expired();
+    }
+    return count;
+}
+}
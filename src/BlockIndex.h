@@ -0,0 +1,119 @@
+#pragma once
+#include "DragonData.h"
+#include "RawFileImage.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace DragonData
+{
+// 场景中可以独立比较的数据块
+enum class BlockKind : uint8_t
+{
+    Scenario = 0, // 整个 Raw::Scenario
+    GameData = 1,
+    Forces = 2,
+    Friendship = 3,
+    Cities = 4,
+    Legions = 5,
+    Characters = 6,
+};
+
+constexpr size_t BLOCK_KIND_COUNT = 7;
+
+// 64 位内容哈希，按 8 字节分组计算，结果与平台和运行次数无关，可以写入磁盘
+uint64_t hash_bytes(const void* data, size_t size);
+
+// 数据块在 Raw::Scenario 中的位置
+struct BlockSpan
+{
+    const uint8_t* data;
+    size_t size;
+};
+
+BlockSpan block_span(const Raw::Scenario& raw, BlockKind kind);
+
+struct ScenarioHashes
+{
+    array<uint64_t, BLOCK_KIND_COUNT> blocks{};
+
+    [[nodiscard]] uint64_t operator[](const BlockKind kind) const
+    {
+        return blocks[static_cast<size_t>(kind)];
+    }
+};
+
+ScenarioHashes hash_scenario(const Raw::Scenario& raw);
+
+// 内容寻址的数据块索引：记录每个不同的数据块出现在哪些文件的哪些场景中。
+// 哈希相同的块会再逐字节比较，因此哈希碰撞不会把不同的内容归为一组。
+class BlockIndex
+{
+public:
+    struct Location
+    {
+        RawFileImagePtr image;
+        uint8_t scenario;
+    };
+
+    // 同一组内的数据块内容完全相同
+    using Group = vector<Location>;
+
+    void add(const RawFileImagePtr& image);
+    // 移除 image 的全部位置。按映像指针查找，不读取内容，映射的文件被改写后仍可移除
+    void remove(const RawFileImagePtr& image);
+    void clear();
+
+    // 返回与 image 中第 scenario 个场景的 kind 块内容相同的所有位置（包括它自己）；未加入索引时返回空组
+    [[nodiscard]] const Group& find(const Raw::Scenario& raw, BlockKind kind) const;
+
+    // 加入索引的数据块总数与其中不同内容的个数
+    [[nodiscard]] size_t blockCount(BlockKind kind) const;
+    [[nodiscard]] size_t distinctCount(BlockKind kind) const;
+
+private:
+    struct Table
+    {
+        unordered_map<uint64_t, vector<Group>> groups;
+        size_t blocks = 0;
+        size_t distinct = 0;
+    };
+
+    array<Table, BLOCK_KIND_COUNT> tables;
+};
+
+// 按内容共享已构建的 Scenario：内容相同的场景（不论来自哪个文件）只构建一份。
+// 池只持有弱引用，没有文件再使用某个场景时它会被释放，因此内存随不同状态的数量而不是文件数增长。
+// 池中的场景是只读的；ScenarioList 在需要修改时会先复制出私有的一份。
+class ScenarioPool
+{
+public:
+    // 线程安全；返回的 Scenario 与 image 中第 index 个场景内容一致
+    shared_ptr<const Scenario> acquire(const RawFileImagePtr& image, size_t index);
+
+    // 当前仍被使用的不同场景个数
+    [[nodiscard]] size_t size() const;
+
+private:
+    struct Entry
+    {
+        Entry(RawFileImagePtr image, const size_t index)
+            : image(std::move(image))
+              , index(index)
+              , scenario(this->image->getScenario(index))
+        {
+        }
+
+        // 持有文件映像，用于比较内容
+        RawFileImagePtr image;
+        size_t index;
+        Scenario scenario;
+    };
+
+    // 调用者需持有 mutex
+    shared_ptr<const Scenario> find(uint64_t hash, const Raw::Scenario& raw);
+
+    mutable std::mutex mutex;
+    unordered_multimap<uint64_t, weak_ptr<const Entry>> entries;
+};
+}
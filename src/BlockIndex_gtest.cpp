@@ -0,0 +1,118 @@
+#include "BlockIndex.h"
+#include "RawFileImage.h"
+#include "ScenarioWriter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <utility>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(BlockIndex, HashBytes)
+{
+    const char data[] = "0123456789abcdefghij";
+    EXPECT_EQ(hash_bytes(data, 20), hash_bytes(std::string(data).data(), 20));
+    EXPECT_NE(hash_bytes(data, 20), hash_bytes(data, 19));
+    EXPECT_NE(hash_bytes(data, 8), hash_bytes(data + 1, 8));
+    EXPECT_NE(hash_bytes(data, 0), hash_bytes(data, 1));
+}
+
+TEST(BlockIndex, GroupIdenticalBlocks)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto copy_path = fs::temp_directory_path() / "BlockIndex_SAVE.DAT";
+    fs::copy_file(data_path / "SAVE.DAT", copy_path, fs::copy_options::overwrite_existing);
+
+    BlockIndex index;
+    std::vector<RawFileImagePtr> images;
+    for (const auto* name : {"SINARIO-01.DAT", "SINARIO-02.DAT", "SINARIO-03.DAT", "SAVE.DAT"})
+    {
+        images.push_back(RawFileImage::open(data_path / name));
+        ASSERT_TRUE(images.back());
+        index.add(images.back());
+    }
+    const auto distinct = index.distinctCount(BlockKind::Scenario);
+    EXPECT_EQ(index.blockCount(BlockKind::Scenario), 16);
+    EXPECT_LE(distinct, 16);
+
+    // 内容相同的文件不增加新的数据块
+    const auto copy = RawFileImage::open(copy_path);
+    ASSERT_TRUE(copy);
+    index.add(copy);
+    EXPECT_EQ(index.blockCount(BlockKind::Scenario), 20);
+    for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+    {
+        EXPECT_EQ(index.blockCount(static_cast<BlockKind>(kind)), 20);
+        EXPECT_LE(index.distinctCount(static_cast<BlockKind>(kind)), distinct);
+    }
+    EXPECT_EQ(index.distinctCount(BlockKind::Scenario), distinct);
+
+    for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        const auto& group = index.find(copy->getScenario(i), BlockKind::Scenario);
+        ASSERT_GE(group.size(), 2);
+        EXPECT_TRUE(std::any_of(group.begin(), group.end(), [&](const BlockIndex::Location& location)
+        {
+            return location.image == images.back() && location.scenario == i;
+        }));
+
+        // 每个数据块都能在索引中找到
+        for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+        {
+            EXPECT_FALSE(index.find(images[0]->getScenario(i), static_cast<BlockKind>(kind)).empty());
+        }
+    }
+
+    auto modified = std::make_unique<Raw::Scenario>(copy->getScenario(0));
+    modified->characters[0].command ^= 1;
+    EXPECT_TRUE(index.find(*modified, BlockKind::Characters).empty());
+    EXPECT_FALSE(index.find(*modified, BlockKind::Cities).empty());
+
+    fs::remove(copy_path);
+}
+
+TEST(BlockIndex, ShareScenariosThroughPool)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto copy_path = fs::temp_directory_path() / "BlockIndex_SINARIO-01.DAT";
+    fs::copy_file(data_path / "SINARIO-01.DAT", copy_path, fs::copy_options::overwrite_existing);
+
+    auto pool = std::make_shared<ScenarioPool>();
+    ScenarioFile first(LoadMode::Lazy, pool);
+    ScenarioFile second(LoadMode::Lazy, pool);
+    ASSERT_TRUE(first.loadFile(data_path / "SINARIO-01.DAT"));
+    ASSERT_TRUE(second.loadFile(copy_path));
+
+    const auto& a = first.getScenarios()[0];
+    const auto& b = second.getScenarios()[0];
+    EXPECT_EQ(&a, &b);
+    // 通过非 const 的文件只读访问也不会脱离 pool
+    EXPECT_EQ(second.getScenarios()[0].getCharacters().size(), a.getCharacters().size());
+    EXPECT_TRUE(second.getScenarios().isShared(0));
+    EXPECT_EQ(pool->size(), 1);
+
+    // 修改前复制出私有的一份，不影响共享的场景
+    auto& edited = second.getScenarios().edit(0);
+    EXPECT_NE(&edited, &a);
+    EXPECT_FALSE(second.getScenarios().isShared(0));
+    edited.getCharacters()[0]->setCommand(a.getCharacters()[0]->getCommand() ^ 1);
+    EXPECT_NE(a.getCharacters()[0]->getCommand(), edited.getCharacters()[0]->getCommand());
+    EXPECT_FALSE(a.getCharacters()[0]->isDirty());
+    EXPECT_EQ(&second.getScenarios()[0], &edited);
+    EXPECT_EQ(&second.getScenarios().edit(0), &edited);
+
+    // 共享的场景只提供常量实体，只有分离出的场景会写回
+    static_assert(std::is_same_v<decltype(a.getCharacters()[0]), const Character*>);
+    auto image = std::make_unique<Raw::File>(first.getImage()->getFile());
+    EXPECT_TRUE(ScenarioWriter::collectChanges(first, *image).getRanges().empty());
+    EXPECT_EQ(ScenarioWriter::collectChanges(second, *image).getByteCount(), sizeof(Raw::Character));
+
+    // 尚未构建的场景直接构建私有的一份，不进入 pool
+    auto& direct = second.getScenarios().edit(1);
+    EXPECT_FALSE(second.getScenarios().isShared(1));
+    EXPECT_EQ(&second.getScenarios()[1], &direct);
+    EXPECT_EQ(pool->size(), 1);
+
+    fs::remove(copy_path);
+}
@@ -0,0 +1,238 @@
+#include "ColumnarTable.h"
+#include "RawFileImage.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    Columnar::ColumnType column_type_of(const FieldType type)
+    {
+        switch (type)
+        {
+        case FieldType::UInt8:
+            return Columnar::ColumnType::UInt8;
+        case FieldType::UInt16:
+            return Columnar::ColumnType::UInt16;
+        case FieldType::UInt24:
+            return Columnar::ColumnType::Int32;
+        case FieldType::Name:
+            return Columnar::ColumnType::Name;
+        default:
+            throw invalid_argument("field has no column type");
+        }
+    }
+
+    // Name 列的宽度取决于字段，返回 0
+    uint8_t column_width(const Columnar::ColumnType type)
+    {
+        switch (type)
+        {
+        case Columnar::ColumnType::UInt8:
+            return sizeof(uint8_t);
+        case Columnar::ColumnType::UInt16:
+            return sizeof(uint16_t);
+        case Columnar::ColumnType::Int32:
+            return sizeof(int32_t);
+        case Columnar::ColumnType::UInt32:
+            return sizeof(uint32_t);
+        default:
+            return 0;
+        }
+    }
+
+    size_t align_up(const size_t value)
+    {
+        return (value + Columnar::ALIGNMENT - 1) / Columnar::ALIGNMENT * Columnar::ALIGNMENT;
+    }
+
+    runtime_error format_error(const fs::path& path)
+    {
+        return runtime_error("invalid columnar table: " + path.string());
+    }
+}
+
+ColumnarWriter::ColumnarWriter(const BlockKind table)
+    : table(table)
+{
+    if (table == BlockKind::Scenario || table == BlockKind::Friendship)
+    {
+        throw invalid_argument("table can not be exported as columns");
+    }
+
+    columns.push_back({"source", Columnar::ColumnType::UInt32, sizeof(uint32_t), nullptr, 0, {}});
+    columns.push_back({"slot", Columnar::ColumnType::UInt8, sizeof(uint8_t), nullptr, 0, {}});
+    for (const auto& field : record_fields(table))
+    {
+        if (field.isReserved()) continue;
+        const auto type = column_type_of(field.type);
+        for (uint8_t element = 0; element < field.count; ++element)
+        {
+            auto name = field.count > 1 ? string(field.name) + "[" + to_string(element) + "]" : string(field.name);
+            const auto width = type == Columnar::ColumnType::Name ? field.size : column_width(type);
+            columns.push_back({std::move(name), type, static_cast<uint8_t>(width), &field, element, {}});
+        }
+    }
+}
+
+uint32_t ColumnarWriter::add(const Raw::Scenario& raw)
+{
+    const auto source = sources++;
+    const auto block = block_span(raw, table);
+    const auto size = record_size(table);
+    for (size_t slot = 0; slot < block.size / size; ++slot)
+    {
+        const auto* record = block.data + slot * size;
+        if (!is_record_occupied(table, record)) continue;
+
+        for (auto& column : columns)
+        {
+            auto& data = column.data;
+            if (column.field == nullptr)
+            {
+                if (column.type == Columnar::ColumnType::UInt32)
+                {
+                    const auto* p = reinterpret_cast<const uint8_t*>(&source);
+                    data.insert(data.end(), p, p + sizeof(source));
+                }
+                else
+                {
+                    data.push_back(static_cast<uint8_t>(slot));
+                }
+                continue;
+            }
+
+            const auto& field = *column.field;
+            const auto* p = record + field.offset + column.element * field.stride;
+            data.insert(data.end(), p, p + field.size);
+            // 3 字节的小端数值补足为 int32
+            if (field.type == FieldType::UInt24) data.push_back(0);
+        }
+        ++rows;
+    }
+    return source;
+}
+
+void ColumnarWriter::write(const fs::path& path) const
+{
+    Columnar::Header header{};
+    memcpy(header.magic, Columnar::MAGIC, sizeof(header.magic));
+    header.version = Columnar::VERSION;
+    header.table = static_cast<uint8_t>(table);
+    header.column_count = static_cast<uint32_t>(columns.size());
+    header.row_count = rows;
+
+    vector<Columnar::Column> infos(columns.size());
+    size_t offset = align_up(sizeof(header) + infos.size() * sizeof(Columnar::Column));
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        auto& info = infos[i];
+        const auto& column = columns[i];
+        column.name.copy(info.name, sizeof(info.name) - 1);
+        info.type = static_cast<uint8_t>(column.type);
+        info.width = column.width;
+        info.offset = offset;
+        info.size = column.data.size();
+        offset = align_up(offset + info.size);
+    }
+
+    const auto temp_path = unique_temp_path(path);
+    try
+    {
+        {
+            ofstream ofs(temp_path, ios::binary | ios::trunc);
+            if (!ofs) throw runtime_error("create columnar table failed: " + path.string());
+
+            static constexpr char PADDING[Columnar::ALIGNMENT] = {};
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            ofs.write(reinterpret_cast<const char*>(infos.data()),
+                      static_cast<streamsize>(infos.size() * sizeof(Columnar::Column)));
+            size_t written = sizeof(header) + infos.size() * sizeof(Columnar::Column);
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                ofs.write(PADDING, static_cast<streamsize>(infos[i].offset - written));
+                ofs.write(reinterpret_cast<const char*>(columns[i].data.data()),
+                          static_cast<streamsize>(infos[i].size));
+                written = infos[i].offset + infos[i].size;
+            }
+            if (!ofs.flush()) throw runtime_error("write columnar table failed: " + path.string());
+        }
+        fs::rename(temp_path, path);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        error_code ec;
+        fs::remove(temp_path, ec);
+        throw runtime_error(e.what());
+    }
+    catch (...)
+    {
+        error_code ec;
+        fs::remove(temp_path, ec);
+        throw;
+    }
+}
+
+ColumnarTable::ColumnarTable(unique_ptr<MappedFile> file)
+    : file(std::move(file))
+{
+}
+
+ColumnarTable::~ColumnarTable() = default;
+
+shared_ptr<const ColumnarTable> ColumnarTable::open(const fs::path& path)
+{
+    shared_ptr<ColumnarTable> table(new ColumnarTable(MappedFile::open(path)));
+
+    // 只校验头部与列描述，列数据本身不做任何检查
+    const auto size = table->file->getSize();
+    if (size < sizeof(Columnar::Header)) throw format_error(path);
+    const auto& header = table->header();
+    if (memcmp(header.magic, Columnar::MAGIC, sizeof(header.magic)) != 0 || header.version != Columnar::VERSION)
+    {
+        throw format_error(path);
+    }
+    if (header.column_count > (size - sizeof(header)) / sizeof(Columnar::Column)) throw format_error(path);
+
+    for (const auto& column : table->getColumns())
+    {
+        if (column.name[sizeof(column.name) - 1] != '\0') throw format_error(path);
+        const auto type = static_cast<Columnar::ColumnType>(column.type);
+        if (column.type > static_cast<uint8_t>(Columnar::ColumnType::Name) || column.width == 0 ||
+            (type != Columnar::ColumnType::Name && column.width != column_width(type)))
+        {
+            throw format_error(path);
+        }
+        if (column.offset % Columnar::ALIGNMENT != 0 || column.size != header.row_count * column.width ||
+            column.offset > size || column.size > size - column.offset)
+        {
+            throw format_error(path);
+        }
+    }
+    return table;
+}
+
+const uint8_t* ColumnarTable::data() const
+{
+    return file->getData();
+}
+
+span<const Columnar::Column> ColumnarTable::getColumns() const
+{
+    return {reinterpret_cast<const Columnar::Column*>(data() + sizeof(Columnar::Header)), header().column_count};
+}
+
+const Columnar::Column* ColumnarTable::findColumn(const string_view name) const
+{
+    for (const auto& column : getColumns())
+    {
+        if (name == column.name) return &column;
+    }
+    return nullptr;
+}
+}
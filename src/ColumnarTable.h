@@ -0,0 +1,189 @@
+#pragma once
+#include "ScenarioDiff.h"
+
+#include <span>
+#include <string_view>
+
+namespace DragonData
+{
+// 列式表文件的布局（多字节数值均为小端序）：
+//   Header | Column × column_count | 各列数据
+// 每列的数据从 64 字节对齐的偏移开始，连续存放 row_count 个定长的值，映射后可直接当作数组读取。
+namespace Columnar
+{
+    constexpr char MAGIC[8] = {'D', 'R', 'G', 'N', 'C', 'O', 'L', '\0'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t ALIGNMENT = 64;
+    constexpr size_t NAME_SIZE = 32;
+
+    enum class ColumnType : uint8_t
+    {
+        UInt8 = 0,
+        UInt16 = 1,
+        Int32 = 2,  // 由 FieldType::UInt24 扩展而来
+        UInt32 = 3,
+        Name = 4,   // BIG5 编码的名字，未解码；宽度为字段大小（人物、城市为 6，GameData 为 32）
+    };
+
+#pragma pack(push, 1)
+    struct Header
+    {
+        char magic[8];
+        uint16_t version;
+        uint8_t table; // BlockKind
+        uint8_t reserved_1;
+        uint32_t column_count;
+        uint64_t row_count;
+    };
+
+    struct Column
+    {
+        char name[NAME_SIZE]; // 以 '\0' 结尾
+        uint8_t type;         // ColumnType
+        uint8_t width;        // 每个值的字节数
+        uint8_t reserved_1[6];
+        uint64_t offset; // 相对文件开头
+        uint64_t size;   // row_count * width
+    };
+#pragma pack(pop)
+
+    // C++ 类型对应的列类型，ColumnarTable::column 据此检查类型
+    template <typename T>
+    struct ColumnTypeOf;
+
+    template <>
+    struct ColumnTypeOf<uint8_t>
+    {
+        static constexpr ColumnType value = ColumnType::UInt8;
+    };
+
+    template <>
+    struct ColumnTypeOf<uint16_t>
+    {
+        static constexpr ColumnType value = ColumnType::UInt16;
+    };
+
+    template <>
+    struct ColumnTypeOf<int32_t>
+    {
+        static constexpr ColumnType value = ColumnType::Int32;
+    };
+
+    template <>
+    struct ColumnTypeOf<uint32_t>
+    {
+        static constexpr ColumnType value = ColumnType::UInt32;
+    };
+
+    template <>
+    struct ColumnTypeOf<Raw::Name>
+    {
+        static constexpr ColumnType value = ColumnType::Name;
+    };
+
+    // 其它长度的名字，例如 GameData 的 32 字节剧本名
+    template <size_t N>
+    struct ColumnTypeOf<array<char, N>>
+    {
+        static constexpr ColumnType value = ColumnType::Name;
+    };
+}
+
+// 把多个场景中同一类实体表按列收集，写成可直接映射的列式表文件。
+// 只收集有效的记录（判定规则与 Scenario 相同），GameData 每个场景一行。
+// 前两列固定为 source（add 的调用序号，uint32）与 slot（原始槽位，uint8），
+// 其后依次为 record_fields 中的非保留字段；数组字段展开为 name[0]、name[1] 等多列。
+class ColumnarWriter
+{
+public:
+    // 只支持 GameData、Forces、Cities、Legions 与 Characters，否则抛出 std::invalid_argument
+    explicit ColumnarWriter(BlockKind table);
+
+    // 返回这些记录在 source 列中的值
+    uint32_t add(const Raw::Scenario& raw);
+
+    [[nodiscard]] BlockKind getTable() const
+    {
+        return table;
+    }
+
+    [[nodiscard]] size_t getRowCount() const
+    {
+        return rows;
+    }
+
+    // 先写入同目录下的临时文件再重命名，失败时抛出 std::runtime_error，path 保持不变
+    void write(const fs::path& path) const;
+
+private:
+    struct ColumnData
+    {
+        string name;
+        Columnar::ColumnType type;
+        uint8_t width;
+        const FieldInfo* field; // source 与 slot 列为 nullptr
+        uint8_t element;
+        vector<uint8_t> data;
+    };
+
+    BlockKind table;
+    vector<ColumnData> columns;
+    size_t rows = 0;
+    uint32_t sources = 0;
+};
+
+class MappedFile;
+
+// 以只读映射方式打开的列式表，读取列时不做任何解析或复制
+class ColumnarTable
+{
+public:
+    ~ColumnarTable();
+
+    ColumnarTable(const ColumnarTable&) = delete;
+    ColumnarTable& operator=(const ColumnarTable&) = delete;
+
+    // 打开失败或文件格式不正确时抛出 std::runtime_error
+    static shared_ptr<const ColumnarTable> open(const fs::path& path);
+
+    [[nodiscard]] BlockKind getTable() const
+    {
+        return static_cast<BlockKind>(header().table);
+    }
+
+    [[nodiscard]] size_t getRowCount() const
+    {
+        return header().row_count;
+    }
+
+    [[nodiscard]] span<const Columnar::Column> getColumns() const;
+
+    // 没有该列时返回 nullptr
+    [[nodiscard]] const Columnar::Column* findColumn(string_view name) const;
+
+    // 列不存在或类型不符时抛出 std::invalid_argument；返回的 span 在表对象存活期间有效
+    template <typename T>
+    [[nodiscard]] span<const T> column(const string_view name) const
+    {
+        const auto* info = findColumn(name);
+        if (info == nullptr) throw invalid_argument("no such column: " + string(name));
+        if (info->type != static_cast<uint8_t>(Columnar::ColumnTypeOf<T>::value) || info->width != sizeof(T))
+        {
+            throw invalid_argument("column type mismatch: " + string(name));
+        }
+        return {reinterpret_cast<const T*>(data() + info->offset), getRowCount()};
+    }
+
+private:
+    explicit ColumnarTable(unique_ptr<MappedFile> file);
+
+    [[nodiscard]] const uint8_t* data() const;
+
+    [[nodiscard]] const Columnar::Header& header() const
+    {
+        return *reinterpret_cast<const Columnar::Header*>(data());
+    }
+
+    unique_ptr<MappedFile> file;
+};
+}
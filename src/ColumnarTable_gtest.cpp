@@ -0,0 +1,129 @@
+#include "ColumnarTable.h"
+#include "RawFileImage.h"
+#include "ScenarioStore.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(ColumnarTable, RoundTripCharacters)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+
+    ColumnarWriter writer(BlockKind::Characters);
+    size_t expected = 0;
+    for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        EXPECT_EQ(writer.add(image->getScenario(i)), i);
+        expected += ScenarioStore(image->getScenario(i)).getCharacters().count;
+    }
+    EXPECT_EQ(writer.getRowCount(), expected);
+
+    auto path = fs::temp_directory_path() / "ColumnarTable_characters.col";
+    writer.write(path);
+
+    const auto table = ColumnarTable::open(path);
+    EXPECT_EQ(table->getTable(), BlockKind::Characters);
+    ASSERT_EQ(table->getRowCount(), expected);
+    for (const auto& column : table->getColumns())
+    {
+        EXPECT_EQ(table->findColumn(column.name), &column);
+        EXPECT_EQ(column.offset % Columnar::ALIGNMENT, 0);
+    }
+    EXPECT_EQ(table->findColumn("reserved_1"), nullptr);
+    EXPECT_THROW((void)table->column<uint16_t>("command"), std::invalid_argument);
+    EXPECT_THROW((void)table->column<uint8_t>("missing"), std::invalid_argument);
+
+    const auto source = table->column<uint32_t>("source");
+    const auto slot = table->column<uint8_t>("slot");
+    const auto command = table->column<uint8_t>("command");
+    const auto name = table->column<Raw::Name>("name");
+
+    // 按列扫描的结果与原始记录一致
+    size_t row = 0;
+    for (uint32_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        ScenarioStore store(image->getScenario(i));
+        const auto& characters = store.getCharacters();
+        for (size_t n = 0; n < characters.count; ++n, ++row)
+        {
+            EXPECT_EQ(source[row], i);
+            EXPECT_EQ(slot[row], characters.slot[n]);
+            EXPECT_EQ(command[row], characters.command[n]);
+            EXPECT_EQ(memcmp(name[row].name, characters.name[n].name, sizeof(Raw::Name)), 0);
+        }
+    }
+    EXPECT_EQ(row, expected);
+
+    // 多个线程同时写同一文件，各自使用不同的临时文件
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&] { EXPECT_NO_THROW(writer.write(path)); });
+        }
+    }
+    EXPECT_EQ(ColumnarTable::open(path)->getRowCount(), expected);
+    for (const auto& entry : fs::directory_iterator(path.parent_path()))
+    {
+        EXPECT_FALSE(entry.path().filename().string().starts_with(path.filename().string() + "."));
+    }
+
+    fs::remove(path);
+}
+
+TEST(ColumnarTable, ExpandArraysAndWideValues)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SAVE.DAT");
+    ASSERT_TRUE(image);
+    const auto& raw = image->getScenario(0);
+
+    EXPECT_THROW(ColumnarWriter(BlockKind::Friendship), std::invalid_argument);
+
+    ColumnarWriter forces(BlockKind::Forces);
+    forces.add(raw);
+    ColumnarWriter game_data(BlockKind::GameData);
+    game_data.add(raw);
+    game_data.add(raw);
+
+    auto forces_path = fs::temp_directory_path() / "ColumnarTable_forces.col";
+    auto game_data_path = fs::temp_directory_path() / "ColumnarTable_game_data.col";
+    forces.write(forces_path);
+    game_data.write(game_data_path);
+
+    {
+        ScenarioStore store(raw);
+        const auto table = ColumnarTable::open(forces_path);
+        ASSERT_EQ(table->getRowCount(), store.getForces().count);
+        const auto money = table->column<int32_t>("money");
+        for (size_t i = 0; i < money.size(); ++i)
+        {
+            EXPECT_EQ(money[i], store.getForces().money[i]);
+        }
+
+        const auto table2 = ColumnarTable::open(game_data_path);
+        ASSERT_EQ(table2->getRowCount(), 2);
+        EXPECT_EQ(table2->column<uint16_t>("year")[1], raw.game_data.year);
+        EXPECT_EQ(table2->column<uint16_t>("next_conscription[2]")[0], raw.game_data.next_conscription[2]);
+        EXPECT_EQ(table2->column<uint32_t>("source")[1], 1);
+        const auto title = table2->column<std::array<char, 32>>("name");
+        EXPECT_EQ(memcmp(title[0].data(), raw.game_data.name, sizeof(raw.game_data.name)), 0);
+        EXPECT_THROW((void)table2->column<Raw::Name>("name"), std::invalid_argument);
+    }
+
+    // 截断的文件不能打开
+    fs::resize_file(forces_path, sizeof(Columnar::Header) + 8);
+    EXPECT_THROW(ColumnarTable::open(forces_path), std::runtime_error);
+    std::ofstream(forces_path, std::ios::binary | std::ios::trunc) << "not a table";
+    EXPECT_THROW(ColumnarTable::open(forces_path), std::runtime_error);
+
+    fs::remove(forces_path);
+    fs::remove(game_data_path);
+}
@@ -0,0 +1,545 @@
+// 不依赖 Qt 的命令行工具，供构建与测试流水线直接调用 DragonData。
+// 除 dump 与 scan 外都只读取文件映像，不构建任何对象。
+#include "BatchEdit.h"
+#include "Exporter.h"
+#include "Parallel.h"
+#include "Query.h"
+#include "RawFileImage.h"
+#include "ScenarioValidator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace DragonData;
+
+namespace
+{
+constexpr auto USAGE = R"(usage: dragonctl <command> [options] <arguments>
+
+commands:
+  scan <game_folder>                      list the scenarios of every file in the folder
+  dump <file>... [--table T] [--format jsonl|csv]
+                                          export decoded records
+  query <table> <file>... [--where "F OP V"]... [--select F]...
+                                          list matching records
+  diff <before> <after>                   list changed fields, exit 1 when they differ
+  validate <file>... [--errors-only]      check references and coordinates, exit 1 on errors
+  patch <file>... (--script S | --rule R)... [--dry-run] [--no-sync]
+                                          apply edit rules atomically, see EditRule::parse
+  apply-save <game_folder> <save>         copy a save in SAVES over SAVE.DAT
+
+options:
+  --json          one JSON object per line instead of tab separated text
+  --threads N     files processed in parallel, 0 uses every core (default)
+
+a directory in place of <file> stands for every .DAT file below it.
+)";
+
+// 退出码：0 成功，1 发现差异、错误或有文件失败，2 参数错误
+constexpr int EXIT_FOUND = 1;
+constexpr int EXIT_USAGE = 2;
+
+struct Arguments
+{
+    vector<string> positional;
+    vector<string> where;
+    vector<string> select;
+    vector<string> scripts;
+    vector<string> rules;
+    string table;
+    string format = "jsonl";
+    size_t threads = 0;
+    bool json = false;
+    bool dry_run = false;
+    bool sync = true;
+    bool errors_only = false;
+};
+
+Arguments parse_arguments(const int argc, char** argv)
+{
+    Arguments args;
+    for (int i = 2; i < argc; ++i)
+    {
+        const string_view arg = argv[i];
+        auto value = [&]() -> string
+        {
+            if (i + 1 >= argc) throw invalid_argument("missing value for " + string(arg));
+            return argv[++i];
+        };
+
+        if (arg == "--json") args.json = true;
+        else if (arg == "--dry-run") args.dry_run = true;
+        else if (arg == "--no-sync") args.sync = false;
+        else if (arg == "--errors-only") args.errors_only = true;
+        else if (arg == "--where") args.where.push_back(value());
+        else if (arg == "--select") args.select.push_back(value());
+        else if (arg == "--script") args.scripts.push_back(value());
+        else if (arg == "--rule") args.rules.push_back(value());
+        else if (arg == "--table") args.table = value();
+        else if (arg == "--format") args.format = value();
+        else if (arg == "--threads")
+        {
+            const auto text = value();
+            const auto [end, ec] = from_chars(text.data(), text.data() + text.size(), args.threads);
+            if (ec != errc() || end != text.data() + text.size()) throw invalid_argument("invalid thread count");
+        }
+        else if (arg.starts_with("--")) throw invalid_argument("unknown option: " + string(arg));
+        else args.positional.emplace_back(arg);
+    }
+    return args;
+}
+
+string path_text(const fs::path& path)
+{
+    const auto text = path.u8string();
+    return {reinterpret_cast<const char*>(text.data()), text.size()};
+}
+
+// 目录展开为其中所有 .DAT 文件，按路径排序
+vector<fs::path> collect_files(const vector<string>& args, const size_t first)
+{
+    vector<fs::path> files;
+    for (size_t i = first; i < args.size(); ++i)
+    {
+        const fs::path path(args[i]);
+        if (!fs::is_directory(path))
+        {
+            files.push_back(path);
+            continue;
+        }
+        vector<fs::path> found;
+        for (const auto& entry : fs::recursive_directory_iterator(path))
+        {
+            auto extension = entry.path().extension().string();
+            ranges::transform(extension, extension.begin(), [](const unsigned char c) { return toupper(c); });
+            if (entry.is_regular_file() && extension == ".DAT") found.push_back(entry.path());
+        }
+        ranges::sort(found);
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    if (files.empty()) throw invalid_argument("no input files");
+    return files;
+}
+
+// 一行输出：--json 时为 JSON 对象，否则为以制表符分隔的值
+class RecordWriter
+{
+public:
+    RecordWriter(OutputBuffer& out, const bool json)
+        : out(out), json(json)
+    {
+    }
+
+    RecordWriter& field(const string_view name, const int64_t value)
+    {
+        key(name);
+        out.writeNumber(value);
+        return *this;
+    }
+
+    RecordWriter& field(const string_view name, const wstring_view value)
+    {
+        key(name);
+        if (json) out.writeJson(value);
+        else out.writeUtf8(value);
+        return *this;
+    }
+
+    // value 为 UTF-8
+    RecordWriter& text(const string_view name, const string_view value)
+    {
+        key(name);
+        if (json) out.writeJson(value);
+        else out.write(value);
+        return *this;
+    }
+
+    void end()
+    {
+        if (json) out.write(first ? "{}" : "}");
+        out.put('\n');
+        first = true;
+    }
+
+private:
+    void key(const string_view name)
+    {
+        if (json)
+        {
+            out.put(first ? '{' : ',');
+            out.writeJson(name);
+            out.put(':');
+        }
+        else if (!first)
+        {
+            out.put('\t');
+        }
+        first = false;
+    }
+
+    OutputBuffer& out;
+    bool json;
+    bool first = true;
+};
+
+void report_error(const fs::path& path, const string& error)
+{
+    cerr << "dragonctl: " << path_text(path) << ": " << error << endl;
+}
+
+RawFileImagePtr open_image(const fs::path& path)
+{
+    auto image = RawFileImage::open(path);
+    if (!image) throw runtime_error("not a scenario file");
+    return image;
+}
+
+int run_scan(const Arguments& args, OutputBuffer& out)
+{
+    if (args.positional.size() != 1) throw invalid_argument("scan takes one game folder");
+    auto folder = args.positional[0];
+    DragonGameObject game;
+    // 只映射文件，场景名按需读取
+    if (!game.openGameFolder(folder, {.mode = LoadMode::Lazy, .threads = args.threads, .share_scenarios = false}))
+    {
+        throw runtime_error("can not open game folder: " + folder);
+    }
+
+    RecordWriter row(out, args.json);
+    auto write = [&](const ScenarioFile& file, const string_view kind)
+    {
+        for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+        {
+            row.text("kind", kind).text("path", path_text(file.getPath())).field("scenario", static_cast<int64_t>(i))
+               .field("name", file.readGameData(i).getName()).end();
+        }
+    };
+    for (const auto& file : game.get_scenario_files())
+    {
+        write(file, "scenario");
+    }
+    for (const auto& file : game.get_saved_files())
+    {
+        write(file, "saved");
+    }
+    if (game.get_default_saved_file().getImage()) write(game.get_default_saved_file(), "default_save");
+    return 0;
+}
+
+int run_dump(const Arguments& args, OutputBuffer& out)
+{
+    const auto files = collect_files(args.positional, 0);
+    ExportFormat format;
+    if (args.format == "jsonl") format = ExportFormat::JsonLines;
+    else if (args.format == "csv") format = ExportFormat::Csv;
+    else throw invalid_argument("unknown format: " + args.format);
+
+    auto tables = ExportTable::All;
+    if (!args.table.empty())
+    {
+        switch (parse_table(args.table))
+        {
+        case BlockKind::Forces:
+            tables = ExportTable::Forces;
+            break;
+        case BlockKind::Cities:
+            tables = ExportTable::Cities;
+            break;
+        case BlockKind::Legions:
+            tables = ExportTable::Legions;
+            break;
+        case BlockKind::Characters:
+            tables = ExportTable::Characters;
+            break;
+        default:
+            tables = ExportTable::GameData;
+            break;
+        }
+    }
+
+    vector<ScenarioFile> loaded(files.size());
+    vector<string> errors(files.size());
+    parallel_for(files.size(), args.threads, [&](const size_t i)
+    {
+        try
+        {
+            if (!loaded[i].loadFile(files[i])) errors[i] = "not a valid scenario file";
+        }
+        catch (const exception& e)
+        {
+            errors[i] = e.what();
+        }
+    });
+
+    Exporter exporter(out, format, tables);
+    int result = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!errors[i].empty())
+        {
+            report_error(files[i], errors[i]);
+            result = EXIT_FOUND;
+            continue;
+        }
+        exporter.write(loaded[i]);
+    }
+    return result;
+}
+
+int run_query(const Arguments& args, OutputBuffer& out)
+{
+    if (args.positional.size() < 2) throw invalid_argument("query takes a table and at least one file");
+    Query query(parse_table(args.positional[0]));
+    for (const auto& condition : args.where)
+    {
+        istringstream words(condition);
+        string field, op, value, rest;
+        if (!(words >> field >> op >> value) || words >> rest)
+        {
+            throw invalid_argument("expected \"<field> <op> <value>\": " + condition);
+        }
+        int64_t number = 0;
+        const auto [end, ec] = from_chars(value.data(), value.data() + value.size(), number);
+        if (ec != errc() || end != value.data() + value.size()) throw invalid_argument("invalid number: " + value);
+        query.where(field, parse_compare_op(op), number);
+    }
+    for (const auto& field : args.select)
+    {
+        query.select(field);
+    }
+
+    const auto files = collect_files(args.positional, 1);
+    vector<vector<QueryRow>> rows(files.size());
+    vector<string> errors(files.size());
+    parallel_for(files.size(), args.threads, [&](const size_t i)
+    {
+        try
+        {
+            const auto image = open_image(files[i]);
+            for (uint8_t s = 0; s < Raw::SCENARIO_COUNT; ++s)
+            {
+                query.run(image->getScenario(s), rows[i], s);
+            }
+        }
+        catch (const exception& e)
+        {
+            errors[i] = e.what();
+        }
+    });
+
+    RecordWriter row(out, args.json);
+    int result = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!errors[i].empty())
+        {
+            report_error(files[i], errors[i]);
+            result = EXIT_FOUND;
+            continue;
+        }
+        const auto path = path_text(files[i]);
+        for (const auto& item : rows[i])
+        {
+            row.text("path", path).field("scenario", item.scenario).field("slot", item.slot);
+            for (size_t c = 0; c < args.select.size(); ++c)
+            {
+                if (const auto* number = get_if<int64_t>(&item.values[c])) row.field(args.select[c], *number);
+                else row.field(args.select[c], get<wstring>(item.values[c]));
+            }
+            row.end();
+        }
+    }
+    return result;
+}
+
+int run_diff(const Arguments& args, OutputBuffer& out)
+{
+    if (args.positional.size() != 2) throw invalid_argument("diff takes two files");
+    const auto before = open_image(args.positional[0]);
+    const auto after = open_image(args.positional[1]);
+
+    vector<FieldChange> changes;
+    diff_files(before->getFile(), after->getFile(), changes);
+
+    RecordWriter row(out, args.json);
+    for (const auto& change : changes)
+    {
+        row.field("scenario", change.scenario).text("table", table_key(change.table)).field("record", change.record)
+           .text("field", change.field->name).field("element", change.element);
+        if (change.field->type == FieldType::Name)
+        {
+            row.field("before", field_text(before->getScenario(change.scenario), change))
+               .field("after", field_text(after->getScenario(change.scenario), change));
+        }
+        else
+        {
+            row.field("before", change.before).field("after", change.after);
+        }
+        row.end();
+    }
+    return changes.empty() ? 0 : EXIT_FOUND;
+}
+
+int run_validate(const Arguments& args, OutputBuffer& out)
+{
+    const auto files = collect_files(args.positional, 0);
+    const ValidationOptions options{.include_warnings = !args.errors_only};
+    vector<vector<ValidationIssue>> issues(files.size());
+    vector<string> errors(files.size());
+    parallel_for(files.size(), args.threads, [&](const size_t i)
+    {
+        try
+        {
+            validate_file(open_image(files[i])->getFile(), issues[i], options);
+        }
+        catch (const exception& e)
+        {
+            errors[i] = e.what();
+        }
+    });
+
+    RecordWriter row(out, args.json);
+    int result = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!errors[i].empty())
+        {
+            report_error(files[i], errors[i]);
+            result = EXIT_FOUND;
+            continue;
+        }
+        const auto path = path_text(files[i]);
+        for (const auto& issue : issues[i])
+        {
+            if (issue.severity == IssueSeverity::Error) result = EXIT_FOUND;
+            row.text("path", path).field("scenario", issue.scenario)
+               .text("severity", issue.severity == IssueSeverity::Error ? "error" : "warning")
+               .text("table", table_key(issue.table)).field("record", issue.record)
+               .field("message", issue_text(issue)).end();
+        }
+    }
+    return result;
+}
+
+int run_patch(const Arguments& args, OutputBuffer& out)
+{
+    BatchEdit edit;
+    for (const auto& script : args.scripts)
+    {
+        ifstream ifs(script, ios::binary);
+        if (!ifs) throw invalid_argument("can not read script: " + script);
+        const string text{istreambuf_iterator<char>(ifs), istreambuf_iterator<char>()};
+        for (auto& rule : parse_edit_script(text))
+        {
+            edit.add(std::move(rule));
+        }
+    }
+    for (const auto& rule : args.rules)
+    {
+        edit.add(EditRule::parse(rule));
+    }
+    if (edit.getRules().empty()) throw invalid_argument("patch needs --script or --rule");
+
+    const auto files = collect_files(args.positional, 0);
+    const auto results = edit.run(files, {.dry_run = args.dry_run, .sync = args.sync, .threads = args.threads});
+
+    RecordWriter row(out, args.json);
+    int result = 0;
+    for (const auto& item : results)
+    {
+        if (!item.error.empty())
+        {
+            report_error(item.path, item.error);
+            result = EXIT_FOUND;
+            continue;
+        }
+        const auto path = path_text(item.path);
+        for (const auto& change : item.changes)
+        {
+            row.text("path", path).field("scenario", change.scenario).text("table", table_key(change.table))
+               .field("record", change.record).text("field", change.field->name).field("element", change.element)
+               .field("before", change.before).field("after", change.after).end();
+        }
+    }
+    return result;
+}
+
+int run_apply_save(const Arguments& args, OutputBuffer&)
+{
+    if (args.positional.size() != 2) throw invalid_argument("apply-save takes a game folder and a save");
+    auto folder = args.positional[0];
+    DragonGameObject game;
+    if (!game.openGameFolder(folder, {.mode = LoadMode::Lazy, .threads = args.threads, .share_scenarios = false}))
+    {
+        throw runtime_error("can not open game folder: " + folder);
+    }
+
+    // 存档可以写作完整路径，也可以只写 SAVES 中的文件名
+    const fs::path save(args.positional[1]);
+    for (const auto& file : game.get_saved_files())
+    {
+        error_code ec;
+        if (file.getPath().filename() != save && !fs::equivalent(file.getPath(), save, ec)) continue;
+        if (!game.applySavedFile(file)) throw runtime_error("apply save failed: " + path_text(file.getPath()));
+        return 0;
+    }
+    throw invalid_argument("save not found in SAVES: " + args.positional[1]);
+}
+}
+
+int main(const int argc, char** argv)
+{
+    if (argc < 2 || string_view(argv[1]) == "--help" || string_view(argv[1]) == "-h")
+    {
+        (argc < 2 ? cerr : cout) << USAGE;
+        return argc < 2 ? EXIT_USAGE : 0;
+    }
+
+    const string_view command = argv[1];
+    // 子命令出错时，已经生成的行先写出，再报告错误
+    OutputBuffer out(1);
+    const auto flush_before_error = [&out]
+    {
+        try
+        {
+            out.flush();
+        }
+        catch (const exception& e)
+        {
+            cerr << "dragonctl: " << e.what() << endl;
+        }
+    };
+    try
+    {
+        const auto args = parse_arguments(argc, argv);
+        int result;
+        if (command == "scan") result = run_scan(args, out);
+        else if (command == "dump") result = run_dump(args, out);
+        else if (command == "query") result = run_query(args, out);
+        else if (command == "diff") result = run_diff(args, out);
+        else if (command == "validate") result = run_validate(args, out);
+        else if (command == "patch") result = run_patch(args, out);
+        else if (command == "apply-save") result = run_apply_save(args, out);
+        else throw invalid_argument("unknown command: " + string(command));
+        out.flush();
+        return result;
+    }
+    catch (const invalid_argument& e)
+    {
+        flush_before_error();
+        cerr << "dragonctl: " << e.what() << "\n\n" << USAGE;
+        return EXIT_USAGE;
+    }
+    catch (const exception& e)
+    {
+        flush_before_error();
+        cerr << "dragonctl: " << e.what() << endl;
+        return EXIT_FOUND;
+    }
+}
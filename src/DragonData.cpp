@@ -1,10 +1,17 @@
 #include "DragonData.h"
+#include "RawFileImage.h"
+#include "ScenarioWriter.h"
+#include "BlockIndex.h"
+#include "Parallel.h"
+#include "ScenarioValidator.h"
 
 #include <iostream>
 #include <cstring>
 #include <fstream>
 #include <stdexcept>
 #include <boost/locale.hpp>
+#include <algorithm>
+#include <atomic>
 
 using namespace std;
 namespace conv = boost::locale::conv;
@@ -17,10 +24,14 @@ wstring name_to_utf8(const char* s, const size_t len)
 
     try
     {
-        string in(s, len);
-        while (!in.empty() && in.back() == '\0') in.pop_back();
+        size_t n = len;
+        while (n > 0 && s[n - 1] == '\0') --n;
 
-        wstring out = conv::to_utf<wchar_t>(in, "BIG5");
+        wstring out;
+        if (!Big5Table::instance().decode(s, n, out))
+        {
+            out = conv::to_utf<wchar_t>(string(s, n), "BIG5");
+        }
         out.erase(
             find_if(out.rbegin(), out.rend(), [](const wchar_t ch) { return ch != L'\0' && ch != L'\u3000'; }).base(),
             out.end());
@@ -42,7 +53,7 @@ Character::Character(const uint index, const Raw::Character& raw)
 {
     property = raw.property;
     avatar = raw.avatar;
-    alias = name_to_utf8(raw.alias.name, std::size(raw.alias.name));
+    alias = &intern_name(raw.alias.name, std::size(raw.alias.name));
     siege_ability = raw.siege_ability;
     field_ability = raw.field_ability;
     naval_ability = raw.naval_ability;
@@ -64,12 +75,12 @@ Character::Character(const uint index, const Raw::Character& raw)
     to_suicide = false;
 }
 
-Force::Force(uint index, const Raw::Force& raw, const CharacterPtrVector& characters, const CityPtrVector& cities)
+Force::Force(uint index, const Raw::Force& raw, const EntityTables& tables)
     : NamedElement(index)
 {
     status = raw.status;
-    warlord = characters[raw.warlord];
-    name = warlord->getName();
+    warlord = tables.character(raw.warlord);
+    if (warlord) name = &warlord->getName();
 
     if (raw.advisor == 0x7f)
     {
@@ -77,10 +88,10 @@ Force::Force(uint index, const Raw::Force& raw, const CharacterPtrVector& charac
     }
     else
     {
-        advisor = make_optional(characters[raw.advisor]);
+        advisor = optional_ptr(tables.character(raw.advisor));
     }
 
-    capital = cities[raw.capital];
+    capital = tables.city(raw.capital);
 
     cavalries = raw.cavalries;
     infantries = raw.infantries;
@@ -99,11 +110,11 @@ Force::Force(uint index, const Raw::Force& raw, const CharacterPtrVector& charac
     }
     else
     {
-        diplomacy_owner = characters[raw.diplomacy_owner];
+        diplomacy_owner = optional_ptr(tables.character(raw.diplomacy_owner));
     }
 }
 
-City::City(uint index, const Raw::City& raw, const CharacterPtrVector& characters)
+City::City(uint index, const Raw::City& raw, const EntityTables& tables)
     : NamedElement(index, raw.name.name, std::size(raw.name.name))
       , axis(raw.axis)
 {
@@ -123,22 +134,20 @@ City::City(uint index, const Raw::City& raw, const CharacterPtrVector& character
     }
     else
     {
-        affairs_owner = characters[raw.affairs_owner];
+        affairs_owner = optional_ptr(tables.character(raw.affairs_owner));
     }
 }
 
-Legion::Legion(const uint index, const Raw::Legion& raw, const ForcePtrVector& forces,
-               const CharacterPtrVector& characters,
-               const CityPtrVector& cities)
+Legion::Legion(const uint index, const Raw::Legion& raw, const EntityTables& tables)
     : NamedElement(index)
       , current_axis(raw.current_axis)
       , target_axis(raw.target_axis)
 {
     state = raw.state;
-    force = forces[raw.force];
-    leader = characters[raw.leader];
-    name = leader->getName();
-    target_city = cities[raw.target_city];
+    force = tables.force(raw.force);
+    leader = tables.character(raw.leader);
+    if (leader) name = &leader->getName();
+    target_city = tables.city(raw.target_city);
 
     total_soldier = raw.total_soldier;
     morale = raw.morale;
@@ -167,19 +176,73 @@ GameData::GameData(const Raw::GameData& raw)
     next_tax_rate = raw.next_tax_rate;
 
     total_forces = raw.total_forces;
-    name = name_to_utf8(raw.name, std::size(raw.name));
+    name = &intern_name(raw.name, std::size(raw.name));
+}
+
+void CharacterIndex::add(const Character& item)
+{
+    const auto slot = item.getIndex();
+    statuses.at(static_cast<size_t>(item.getStatus())).set(slot);
+
+    if (const auto force = item.getForceCaptureSlot(); force < MAX_FORCES)
+    {
+        auto& list = forces[force];
+        list.insert(upper_bound(list.begin(), list.end(), slot), slot);
+    }
+
+    for (size_t i = 0; i < CHARACTER_ABILITY_COUNT; ++i)
+    {
+        auto& list = abilities[i];
+        const auto key = static_cast<uint16_t>(item.getAbility(static_cast<CharacterAbility>(i)) << 8 | slot);
+        list.insert(upper_bound(list.begin(), list.end(), key), key);
+    }
+}
+
+vector<uint8_t> CharacterIndex::withAbility(const CharacterAbility ability, const uint8_t min, const uint8_t max) const
+{
+    vector<uint8_t> result;
+    if (min > max) return result;
+    const auto& list = abilities.at(static_cast<size_t>(ability));
+    const auto first = lower_bound(list.begin(), list.end(), static_cast<uint16_t>(min << 8));
+    const auto last = upper_bound(first, list.end(), static_cast<uint16_t>(max << 8 | 0xff));
+    result.reserve(last - first);
+    for (auto it = first; it != last; ++it)
+    {
+        result.push_back(static_cast<uint8_t>(*it));
+    }
+    return result;
+}
+
+void CharacterIndex::updateStatus(const uint8_t slot, const CharacterStatus before, const CharacterStatus after)
+{
+    statuses.at(static_cast<size_t>(before)).reset(slot);
+    statuses.at(static_cast<size_t>(after)).set(slot);
+}
+
+void CharacterIndex::updateAbility(const CharacterAbility ability, const uint8_t slot, const uint8_t before,
+                                   const uint8_t after)
+{
+    auto& list = abilities.at(static_cast<size_t>(ability));
+    const auto old_key = static_cast<uint16_t>(before << 8 | slot);
+    const auto new_key = static_cast<uint16_t>(after << 8 | slot);
+    const auto it = lower_bound(list.begin(), list.end(), old_key);
+    if (it == list.end() || *it != old_key) throw logic_error("character index out of sync");
+    list.erase(it);
+    list.insert(upper_bound(list.begin(), list.end(), new_key), new_key);
 }
 
 Scenario::Scenario(const Raw::Scenario& raw)
     : game_data(raw.game_data)
 {
+    // 每张表填充时同时建立槽位映射，后构建的表才能按槽位解析关联
+
     // characters
     for (size_t i = 0; i < std::size(raw.characters); ++i)
     {
         const auto& rawItem = raw.characters[i];
         if (rawItem.name.name[0] == 0) continue;
-        auto item = make_shared<Character>(i, rawItem);
-        characters.push_back(item);
+        tables.character_slots.set(i, static_cast<uint8_t>(tables.characters.size()));
+        tables.characters.push_back(make_shared<Character>(i, rawItem));
     }
 
     // cities
@@ -187,7 +250,8 @@ Scenario::Scenario(const Raw::Scenario& raw)
     {
         const Raw::City& rawItem = raw.cities[i];
         if (rawItem.axis.x == 0 || rawItem.axis.y == 0) continue;
-        cities.emplace_back(make_shared<City>(i, rawItem, characters));
+        tables.city_slots.set(i, static_cast<uint8_t>(tables.cities.size()));
+        tables.cities.emplace_back(make_shared<City>(i, rawItem, tables));
     }
 
     // forces
@@ -195,7 +259,8 @@ Scenario::Scenario(const Raw::Scenario& raw)
     {
         const auto& rawItem = raw.forces[i];
         if (rawItem.status == 0) continue;
-        forces.emplace_back(make_shared<Force>(i, rawItem, characters, cities));
+        tables.force_slots.set(i, static_cast<uint8_t>(tables.forces.size()));
+        tables.forces.emplace_back(make_shared<Force>(i, rawItem, tables));
     }
 
     // legions
@@ -203,31 +268,116 @@ Scenario::Scenario(const Raw::Scenario& raw)
     {
         const auto& rawItem = raw.legions[i];
         if (rawItem.current_axis.x == 0 || rawItem.current_axis.y == 0) continue;
-        legions.emplace_back(make_shared<Legion>(i, rawItem, forces, characters, cities));
+        tables.legions.emplace_back(make_shared<Legion>(i, rawItem, tables));
     }
 
     resolve();
+
+    character_index = make_unique<CharacterIndex>();
+    for (const auto& item : tables.characters)
+    {
+        character_index->add(*item);
+        item->character_index = character_index.get();
+    }
+
+    for (const auto& item : tables.cities)
+    {
+        city_grid.insert(item->getIndex(), item->getAxis().x, item->getAxis().y);
+    }
+    legion_grid = make_unique<SpatialGrid>(6);
+    for (const auto& item : tables.legions)
+    {
+        legion_grid->insert(item->getIndex(), item->getCurrentAxis().x, item->getCurrentAxis().y);
+        item->legion_grid = legion_grid.get();
+    }
 }
 
-constexpr auto FILE_SIZE = Raw::SCENARIO_DATA_SIZE * Raw::SCENARIO_COUNT;
+ScenarioList::ScenarioList(RawFileImagePtr image, ScenarioPoolPtr pool)
+    : state(make_shared<State>())
+{
+    state->image = std::move(image);
+    state->pool = std::move(pool);
+}
+
+const Scenario& ScenarioList::operator[](const size_t index) const
+{
+    if (!state) throw out_of_range("scenario list is empty");
+    if (index >= size()) throw out_of_range("scenario index out of range");
+    call_once(state->built[index], [&]
+    {
+        if (state->pool)
+        {
+            state->shared[index] = state->pool->acquire(state->image, index);
+            state->current[index] = state->shared[index].get();
+        }
+        else
+        {
+            state->owned[index] = make_shared<Scenario>(state->image->getScenario(index));
+            state->current[index] = state->owned[index].get();
+        }
+    });
+    return *state->current[index].load(memory_order_acquire);
+}
+
+Scenario& ScenarioList::edit(const size_t index)
+{
+    if (!state) throw out_of_range("scenario list is empty");
+    if (index >= size()) throw out_of_range("scenario index out of range");
+    call_once(state->built[index], [&]
+    {
+        state->owned[index] = make_shared<Scenario>(state->image->getScenario(index));
+        state->current[index] = state->owned[index].get();
+    });
+    lock_guard lock(state->detach_mutex);
+    auto& owned = state->owned[index];
+    if (!owned)
+    {
+        owned = make_shared<Scenario>(state->image->getScenario(index));
+        state->current[index].store(owned.get(), memory_order_release);
+    }
+    return *owned;
+}
+
+bool ScenarioList::isMaterialized(const size_t index) const
+{
+    return state && state->current.at(index).load(memory_order_acquire) != nullptr;
+}
+
+bool ScenarioList::isShared(const size_t index) const
+{
+    if (!state) return false;
+    lock_guard lock(state->detach_mutex);
+    return state->current.at(index).load() != nullptr && !state->owned[index];
+}
 
 bool ScenarioFile::loadFile(const fs::path& filepath)
+{
+    return load(filepath, ImageMode::Map);
+}
+
+bool ScenarioFile::load(const fs::path& filepath, const ImageMode mode)
 {
     file_path = filepath;
-    std::ifstream ifs(filepath, std::ios::binary);
-    if (!ifs) throw std::runtime_error("open scenario file failed: " + filepath.string());
+    scenarios = ScenarioList();
+
+    image = RawFileImage::open(filepath, mode);
+    if (!image) return false;
 
-    std::array<char, FILE_SIZE> data{};
-    ifs.read(data.data(), FILE_SIZE);
+    // 关联越界的文件按此构建对象会越界访问，在构建任何场景之前拒绝
+    if (!is_valid_file(image->getFile()))
+    {
+        image.reset();
+        return false;
+    }
+
+    scenarios = ScenarioList(image, pool);
+    if (load_mode == LoadMode::Lazy) return true;
 
-    std::vector<Scenario> result;
-    const auto buffer = reinterpret_cast<const char*>(data.data());
-    const auto* rawFile = reinterpret_cast<const Raw::File*>(buffer);
     try
     {
-        for (const auto& scenario : rawFile->scenarios)
+        for (size_t i = 0; i < scenarios.size(); ++i)
         {
-            scenarios.emplace_back(scenario);
+            (void)std::as_const(scenarios)[i];
         }
     }
     catch (...)
@@ -237,14 +387,38 @@ bool ScenarioFile::loadFile(const fs::path& filepath)
     return true;
 }
 
+GameData ScenarioFile::readGameData(const size_t index) const
+{
+    if (!image) throw out_of_range("scenario file is not loaded");
+    if (index >= Raw::SCENARIO_COUNT) throw out_of_range("scenario index out of range");
+    return GameData(image->getScenario(index).game_data);
+}
+
 bool SavedScenarioFile::loadFile(const fs::path& filepath)
 {
-    if (!ScenarioFile::loadFile(filepath)) return false;
+    if (!load(filepath, ImageMode::Copy)) return false;
     timestamp = fs::last_write_time(filepath);
     return true;
 }
 
-bool DragonGameObject::openGameFolder(string& folder_path)
+namespace
+{
+    vector<fs::path> list_data_files(const fs::path& dir)
+    {
+        vector<fs::path> result;
+        for (const auto& entry : fs::directory_iterator(dir))
+        {
+            if (!entry.is_regular_file()) continue;
+            const auto& file_path = entry.path();
+            if (auto ext = file_path.extension().string(); !(ext == ".dat" || ext == ".DAT")) continue;
+            result.push_back(file_path);
+        }
+        sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+bool DragonGameObject::openGameFolder(string& folder_path, const ScanOptions& options)
 {
     fs::path root(folder_path);
     fs::path scenario_dir = root / "SINARIO";
@@ -256,42 +430,173 @@ bool DragonGameObject::openGameFolder(string& folder_path)
         return false;
     }
 
+    vector<fs::path> scenario_paths;
+    vector<fs::path> saved_paths;
+    bool has_default_save;
     try
     {
-        for (const auto& entry : fs::directory_iterator(scenario_dir))
-        {
-            if (!entry.is_regular_file()) continue;
-            const auto& file_path = entry.path();
-            if (auto ext = file_path.extension().string(); !(ext == ".dat" || ext == ".DAT")) continue;
+        scenario_paths = list_data_files(scenario_dir);
+        saved_paths = list_data_files(saved_dir);
+        has_default_save = fs::exists(save_data_path) && fs::is_regular_file(save_data_path);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        cerr << "Failed to scan scenario directory: " << e.what() << endl;
+        return false;
+    }
 
-            ScenarioFile item;
-            if (!item.loadFile(file_path)) continue;
-            scenario_files.emplace_back(std::move(item));
-        }
+    // 任务顺序即交付顺序，结果与线程调度无关
+    auto pool = options.share_scenarios ? make_shared<ScenarioPool>() : nullptr;
+    vector<ScenarioFile> scenarios(scenario_paths.size(), ScenarioFile(options.mode, pool));
+    vector<SavedScenarioFile> saves(saved_paths.size(), SavedScenarioFile(options.mode, pool));
+    SavedScenarioFile default_save(options.mode, pool);
+
+    struct Task
+    {
+        ScanFileKind kind;
+        const fs::path* path;
+        ScenarioFile* file;
+    };
+
+    vector<Task> tasks;
+    tasks.reserve(scenario_paths.size() + saved_paths.size() + 1);
+    for (size_t i = 0; i < scenario_paths.size(); ++i)
+    {
+        tasks.push_back({ScanFileKind::Scenario, &scenario_paths[i], &scenarios[i]});
+    }
+    for (size_t i = 0; i < saved_paths.size(); ++i)
+    {
+        tasks.push_back({ScanFileKind::Saved, &saved_paths[i], &saves[i]});
+    }
+    if (has_default_save)
+    {
+        tasks.push_back({ScanFileKind::DefaultSave, &save_data_path, &default_save});
+    }
+
+    enum : uint8_t { Pending, Loaded, Failed };
+    vector<uint8_t> states(tasks.size(), Pending);
+    mutex merge_mutex;
+    size_t done = 0;
+    size_t delivered = 0;
 
-        for (const auto& entry : fs::directory_iterator(saved_dir))
+    parallel_for(tasks.size(), options.threads, [&](const size_t i)
+    {
+        // 取消后剩余的任务直接跳过
+        if (options.stop.stop_requested()) return;
+
+        const auto& task = tasks[i];
+        bool loaded;
+        try
         {
-            if (!entry.is_regular_file()) continue;
-            const auto& file_path = entry.path();
-            if (auto ext = file_path.extension().string(); !(ext == ".dat" || ext == ".DAT")) continue;
+            loaded = task.file->loadFile(*task.path);
+        }
+        catch (const exception& e)
+        {
+            cerr << "Failed to load scenario file: " << e.what() << endl;
+            loaded = false;
+        }
 
-            SavedScenarioFile item;
-            if (!item.loadFile(file_path)) continue;
-            saved_files.emplace_back(std::move(item));
+        lock_guard lock(merge_mutex);
+        states[i] = loaded ? Loaded : Failed;
+        ++done;
+        for (; delivered < tasks.size() && states[delivered] != Pending; ++delivered)
+        {
+            if (states[delivered] == Loaded && options.on_file)
+            {
+                options.on_file(*tasks[delivered].file, tasks[delivered].kind);
+            }
         }
+        if (options.on_progress) options.on_progress(done, tasks.size());
+    });
+
+    if (options.stop.stop_requested()) return false;
 
-        if (fs::exists(save_data_path) && fs::is_regular_file(save_data_path))
+    scenario_files.clear();
+    saved_files.clear();
+    default_saved_file = SavedScenarioFile(options.mode);
+    auto index = make_shared<BlockIndex>();
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        if (states[i] != Loaded) continue;
+        index->add(tasks[i].file->getImage());
+        switch (tasks[i].kind)
         {
-            default_saved_file.loadFile(save_data_path);
+        case ScanFileKind::Scenario:
+            scenario_files.emplace_back(std::move(*tasks[i].file));
+            break;
+        case ScanFileKind::Saved:
+            saved_files.emplace_back(std::move(static_cast<SavedScenarioFile&>(*tasks[i].file)));
+            break;
+        case ScanFileKind::DefaultSave:
+            default_saved_file = std::move(default_save);
+            break;
         }
     }
-    catch (const fs::filesystem_error& e)
+
+    scenario_pool = std::move(pool);
+    block_index = std::move(index);
+    gameFolderPath = folder_path;
+    load_mode = options.mode;
+    return true;
+}
+
+void DragonGameObject::replaceIndexedImage(const RawFileImagePtr& removed, const RawFileImagePtr& added)
+{
+    // 索引可能仍被其他线程持有，修改副本后再替换
+    auto index = block_index ? make_shared<BlockIndex>(*block_index) : make_shared<BlockIndex>();
+    if (removed) index->remove(removed);
+    if (added) index->add(added);
+    block_index = std::move(index);
+}
+
+void DragonGameObject::putSavedFile(SavedScenarioFile file, const ScanFileKind kind)
+{
+    if (!file.getImage()) throw invalid_argument("saved file is not loaded");
+    switch (kind)
     {
-        cerr << "Failed to scan scenario directory: " << e.what() << endl;
-        return false;
+    case ScanFileKind::DefaultSave:
+        replaceIndexedImage(default_saved_file.getImage(), file.getImage());
+        default_saved_file = std::move(file);
+        return;
+    case ScanFileKind::Saved:
+    {
+        const auto it = lower_bound(saved_files.begin(), saved_files.end(), file.getPath(),
+                                    [](const SavedScenarioFile& item, const fs::path& path)
+                                    {
+                                        return item.getPath() < path;
+                                    });
+        if (it != saved_files.end() && it->getPath() == file.getPath())
+        {
+            replaceIndexedImage(it->getImage(), file.getImage());
+            *it = std::move(file);
+        }
+        else
+        {
+            replaceIndexedImage(nullptr, file.getImage());
+            saved_files.insert(it, std::move(file));
+        }
+        return;
     }
+    default:
+        throw invalid_argument("only saved files can be replaced");
+    }
+}
 
-    gameFolderPath = folder_path;
+bool DragonGameObject::removeSavedFile(const fs::path& path)
+{
+    if (default_saved_file.getImage() && default_saved_file.getPath() == path)
+    {
+        replaceIndexedImage(default_saved_file.getImage(), nullptr);
+        default_saved_file = SavedScenarioFile(load_mode);
+        return true;
+    }
+    const auto it = find_if(saved_files.begin(), saved_files.end(), [&path](const SavedScenarioFile& item)
+    {
+        return item.getPath() == path;
+    });
+    if (it == saved_files.end()) return false;
+    replaceIndexedImage(it->getImage(), nullptr);
+    saved_files.erase(it);
     return true;
 }
 
@@ -300,9 +605,12 @@ bool DragonGameObject::applySavedFile(const SavedScenarioFile& saved_file) const
     const auto target_path = gameFolderPath / "SAVE.DAT";
     try
     {
-        fs::copy_file(saved_file.getPath(), target_path, fs::copy_options::overwrite_existing);
+        // 复制磁盘上的存档，内存中尚未保存的修改不写入；游戏随时可能读取 SAVE.DAT，因此通过临时文件原子替换
+        const auto image = RawFileImage::open(saved_file.getPath(), ImageMode::Copy);
+        if (!image) throw runtime_error("unexpected scenario file size: " + saved_file.getPath().string());
+        replace_file_atomically(target_path, span(image->getData(), image->getFileSize()), true);
     }
-    catch (const fs::filesystem_error& e)
+    catch (const runtime_error& e)
     {
         cerr << "Failed to apply saved file: " << e.what() << endl;
         return false;
@@ -314,7 +622,7 @@ bool DragonGameObject::applySavedFile(const SavedScenarioFile& saved_file) const
 std::wostream& operator<<(std::wostream& os, const NamedElement& n)
 {
     os << "NamedElement{name=" << n.getName() << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -322,7 +630,7 @@ std::wostream& operator<<(std::wostream& os, const NamedElement& n)
 std::wostream& operator<<(std::wostream& os, const Axis& a)
 {
     os << "Axis{x=" << a.x << ", y=" << a.y << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -330,7 +638,7 @@ std::wostream& operator<<(std::wostream& os, const Axis& a)
 std::wostream& operator<<(std::wostream& os, const Troop& t)
 {
     os << "Troop{count=" << t.getCount() << ", type=" << t.getTroopType() << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -340,7 +648,7 @@ std::wostream& operator<<(std::wostream& os, const Conscription& c)
     os << "Conscription{cavalry=" << c.cavalry
         << ", infantry=" << c.infantry
         << ", archer=" << c.archer << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -356,7 +664,7 @@ std::wostream& operator<<(std::wostream& os, const Character& item)
         << ", is_warlord=" << (item.isWarlord() ? "true" : "false")
         << ", to_board=" << (item.isToBoard() ? "true" : "false")
         << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -381,21 +689,21 @@ std::wostream& operator<<(std::wostream& os, const Force& item)
         << ", cities=" << static_cast<int>(item.getCities())
         << ", diplomacy_owner=" << (dip ? dip->getName() : L"<none>")
         << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
 std::wostream& operator<<(std::wostream& os, const City& item)
 {
     os << "City{name=" << item.getName() << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
 std::wostream& operator<<(std::wostream& os, const Legion& item)
 {
     os << "Legion{name=" << item.getName() << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -413,7 +721,7 @@ std::wostream& operator<<(std::wostream& os, const GameData& item)
         << ", next_conscription=" << item.getNextConscription()
         << ", total_forces=" << static_cast<int>(item.getTotalForces())
         << "}"
-        << endl;
+        << '\n';
     return os;
 }
 
@@ -424,7 +732,7 @@ std::wostream& operator<<(std::wostream& os, const Scenario& item)
         << ", forces_count=" << item.getForces().size()
         << ", cities_count=" << item.getCities().size()
         << ", legions_count=" << item.getLegions().size()
-        << ", characters_count=" << item.getCharacters().size() << endl;
+        << ", characters_count=" << item.getCharacters().size() << '\n';
 
     for (const auto& force : item.getForces())
     {
@@ -446,29 +754,29 @@ std::wostream& operator<<(std::wostream& os, const Scenario& item)
         os << *character;
     }
 
-    os << "}" << endl;
+    os << "}" << '\n';
     return os;
 }
 
 std::wostream& operator<<(std::wostream& os, const ScenarioFile& item)
 {
-    os << "ScenarioFile{path=" << item.getPath().wstring() << ", scenarios=" << item.getScenarios().size() << endl;
+    os << "ScenarioFile{path=" << item.getPath().wstring() << ", scenarios=" << item.getScenarios().size() << '\n';
     for (const auto& scenario : item.getScenarios())
     {
         os << scenario;
     }
-    os << "}" << endl;
+    os << "}" << '\n';
     return os;
 }
 
 std::wostream& operator<<(std::wostream& os, const SavedScenarioFile& item)
 {
-    os << "SavedFile{path=" << item.getPath().wstring() << "}" << endl;
+    os << "SavedFile{path=" << item.getPath().wstring() << "}" << '\n';
     for (const auto& scenario : item.getScenarios())
     {
         os << scenario;
     }
-    os << "}" << endl;
+    os << "}" << '\n';
     return os;
 }
 
@@ -481,7 +789,7 @@ std::wostream& operator<<(std::wostream& os, const DragonGameObject& item)
         << ", scenario_files=" << item.get_scenario_files().size()
         << ", saved_files=" << item.get_saved_files().size()
         << "}"
-        << endl;
+        << '\n';
     return os;
 }
 }
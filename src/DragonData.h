@@ -1,13 +1,25 @@
 #pragma once
 #include <string>
 #include <array>
+#include <bitset>
+#include <span>
+#include <iterator>
+#include <ranges>
 #include <vector>
 #include <unordered_map>
 #include <optional>
 #include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <stop_token>
+#include <utility>
 #include <stdexcept>
 #include <cstring>
+#include <cstddef>
 #include <boost/locale/date_time.hpp>
+#include "NameTable.h"
+#include "SpatialGrid.h"
 
 using namespace std;
 
@@ -158,6 +170,27 @@ namespace Raw
     };
 
 #pragma pack(pop)
+
+    constexpr size_t FILE_SIZE = SCENARIO_DATA_SIZE * SCENARIO_COUNT;
+
+    // 记录的大小与各数据表在场景中的偏移由文件格式决定，reserved_N 的长度数错时在这里报错
+    static_assert(sizeof(Force) == 64);
+    static_assert(sizeof(City) == 32);
+    static_assert(sizeof(Legion) == 64);
+    static_assert(sizeof(Character) == 32);
+    static_assert(sizeof(GameData) == 128);
+    static_assert(sizeof(Friendship) == 24);
+    static_assert(offsetof(Scenario, forces) == 0x0080);
+    static_assert(offsetof(Scenario, friendship) == 0x0680);
+    static_assert(offsetof(Scenario, cities) == 0x08c0);
+    static_assert(offsetof(Scenario, reserved_1) == 0x20c0);
+    static_assert(offsetof(Scenario, legions) == 0x22c0);
+    static_assert(offsetof(Scenario, characters) == 0x42c0);
+    static_assert(offsetof(Scenario, reserved_2) == 0x52c0);
+    static_assert(sizeof(Scenario) == SCENARIO_DATA_SIZE);
+    static_assert(sizeof(File) == FILE_SIZE);
+    // 部分场景文件（如 SINARIO-03.DAT）缺少最后一个场景末尾的保留字节
+    constexpr size_t MIN_FILE_SIZE = FILE_SIZE - sizeof(Scenario::reserved_2);
 }
 
 namespace fs = filesystem;
@@ -177,23 +210,43 @@ public:
         return index;
     }
 
+    // 通过 setter 修改过、尚未写回文件
+    [[nodiscard]] bool isDirty() const
+    {
+        return dirty;
+    }
+
+    void clearDirty()
+    {
+        dirty = false;
+    }
+
+protected:
+    void markDirty()
+    {
+        dirty = true;
+    }
+
 private:
     uint index;
+    bool dirty = false;
 };
 
 wstring name_to_utf8(const char* s, size_t len);
 
-class NamedElement : Element
+// 名字均指向驻留表中的字符串，构造实体时无需复制或重复解码
+class NamedElement : public Element
 {
 public:
     explicit NamedElement(const uint index)
         : Element(index)
+          , name(&empty_name())
     {
     }
 
     NamedElement(const uint index, const char* s, const size_t len)
         : Element(index)
-          , name(name_to_utf8(s, len))
+          , name(&intern_name(s, len))
     {
     }
 
@@ -204,12 +257,24 @@ public:
     }
 
 protected:
-    wstring name;
+    const wstring* name;
+
+    static const wstring& empty_name()
+    {
+        static const wstring empty;
+        return empty;
+    }
+
+    void assignName(const wstring& value, const size_t len)
+    {
+        name = &intern_encoded_name(value, len);
+        markDirty();
+    }
 
 public:
     [[nodiscard]] virtual const wstring& getName() const
     {
-        return name;
+        return *name;
     }
 };
 
@@ -278,11 +343,196 @@ typedef vector<CityPtr> CityPtrVector;
 typedef vector<ForcePtr> ForcePtrVector;
 typedef vector<LegionPtr> LegionPtrVector;
 
+// 表示不存在的关联
+constexpr uint8_t NO_INDEX = 0xff;
+
+constexpr size_t MAX_FORCES = sizeof(Raw::Scenario::forces) / sizeof(Raw::Force);
+constexpr size_t MAX_CITIES = sizeof(Raw::Scenario::cities) / sizeof(Raw::City);
+constexpr size_t MAX_LEGIONS = sizeof(Raw::Scenario::legions) / sizeof(Raw::Legion);
+constexpr size_t MAX_CHARACTERS = sizeof(Raw::Scenario::characters) / sizeof(Raw::Character);
+
+// 原始槽位到紧凑下标的映射。表有 256 项，文件中任何一个关联字节都可以直接查表：
+// 空槽位或超出实体表大小的取值得到 NO_INDEX，不需要另做范围检查。
+class SlotMap
+{
+public:
+    SlotMap()
+    {
+        map.fill(NO_INDEX);
+    }
+
+    void set(const size_t slot, const uint8_t index)
+    {
+        map[slot] = index;
+    }
+
+    [[nodiscard]] uint8_t operator[](const uint8_t slot) const
+    {
+        return map[slot];
+    }
+
+    // 槽位为空时返回空指针
+    template <typename T>
+    [[nodiscard]] shared_ptr<T> find(const uint8_t slot, const vector<shared_ptr<T>>& items) const
+    {
+        const auto index = map[slot];
+        return index == NO_INDEX ? nullptr : items[index];
+    }
+
+private:
+    array<uint8_t, 256> map;
+};
+
+// 场景中的实体表：各表只保存有效的记录，关联一律通过槽位映射按原始槽位解析
+struct EntityTables
+{
+    CharacterPtrVector characters;
+    CityPtrVector cities;
+    ForcePtrVector forces;
+    LegionPtrVector legions;
+    SlotMap character_slots;
+    SlotMap city_slots;
+    SlotMap force_slots;
+
+    [[nodiscard]] CharacterPtr character(const uint8_t slot) const
+    {
+        return character_slots.find(slot, characters);
+    }
+
+    [[nodiscard]] CityPtr city(const uint8_t slot) const
+    {
+        return city_slots.find(slot, cities);
+    }
+
+    [[nodiscard]] ForcePtr force(const uint8_t slot) const
+    {
+        return force_slots.find(slot, forces);
+    }
+};
+
+// 把可能为空的指针转换为 optional，空指针对应 nullopt
+template <typename T>
+optional<shared_ptr<T>> optional_ptr(shared_ptr<T> ptr)
+{
+    if (!ptr) return nullopt;
+    return ptr;
+}
+
+// 实体表的只读视图，元素为指向常量的指针。
+// 池中的场景在多个文件之间共享，通过 const Scenario& 无法修改；修改必须先经 ScenarioList::edit 取得独占的场景。
+template <typename T>
+class ConstPtrView : public ranges::view_interface<ConstPtrView<T>>
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_concept = random_access_iterator_tag;
+        using iterator_category = input_iterator_tag;
+        using value_type = const T*;
+        using difference_type = ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(typename vector<shared_ptr<T>>::const_iterator it) : it(it)
+        {
+        }
+
+        const T* operator*() const
+        {
+            return it->get();
+        }
+
+        const T* operator[](const difference_type n) const
+        {
+            return it[n].get();
+        }
+
+        iterator& operator++()
+        {
+            ++it;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            return iterator(it++);
+        }
+
+        iterator& operator--()
+        {
+            --it;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            return iterator(it--);
+        }
+
+        iterator& operator+=(const difference_type n)
+        {
+            it += n;
+            return *this;
+        }
+
+        iterator& operator-=(const difference_type n)
+        {
+            it -= n;
+            return *this;
+        }
+
+        friend iterator operator+(const iterator& i, const difference_type n)
+        {
+            return iterator(i.it + n);
+        }
+
+        friend iterator operator+(const difference_type n, const iterator& i)
+        {
+            return iterator(i.it + n);
+        }
+
+        friend iterator operator-(const iterator& i, const difference_type n)
+        {
+            return iterator(i.it - n);
+        }
+
+        friend difference_type operator-(const iterator& a, const iterator& b)
+        {
+            return a.it - b.it;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) = default;
+        friend auto operator<=>(const iterator& a, const iterator& b) = default;
+
+    private:
+        typename vector<shared_ptr<T>>::const_iterator it;
+    };
+
+    explicit ConstPtrView(const vector<shared_ptr<T>>& items) : items(&items)
+    {
+    }
+
+    [[nodiscard]] iterator begin() const
+    {
+        return iterator(items->begin());
+    }
+
+    [[nodiscard]] iterator end() const
+    {
+        return iterator(items->end());
+    }
+
+private:
+    const vector<shared_ptr<T>>* items;
+};
+
 
 class Force final : public NamedElement
 {
 public:
-    Force(uint index, const Raw::Force& raw, const CharacterPtrVector& characters, const CityPtrVector& cities);
+    // tables 中的人物与城市必须已经构建；指向空槽位的关联为空指针
+    Force(uint index, const Raw::Force& raw, const EntityTables& tables);
 
     [[nodiscard]] uint8_t getStatus() const
     {
@@ -339,6 +589,32 @@ public:
         return diplomacy_owner.value_or(nullptr).get();
     }
 
+    void setCavalries(const uint16_t value)
+    {
+        cavalries = value;
+        markDirty();
+    }
+
+    void setInfantries(const uint16_t value)
+    {
+        infantries = value;
+        markDirty();
+    }
+
+    void setArchers(const uint16_t value)
+    {
+        archers = value;
+        markDirty();
+    }
+
+    // 金钱以 24 位保存，超出范围时抛出 std::out_of_range
+    void setMoney(const int32_t value)
+    {
+        if (value < 0 || value > 0xffffff) throw out_of_range("money must fit in 24 bits");
+        money = value;
+        markDirty();
+    }
+
 private:
     uint8_t status;
     CharacterPtr warlord;
@@ -380,29 +656,71 @@ inline CharacterStatus CharacterStatusFromRaw(const uint8_t v) noexcept
     }
 }
 
-class Character final : public NamedElement
+constexpr size_t CHARACTER_STATUS_COUNT = 5;
+
+enum class CharacterAbility : uint8_t
+{
+    Siege = 0,
+    Field = 1,
+    Naval = 2,
+    Battle = 3,
+    Command = 4,
+    Politics = 5,
+};
+
+constexpr size_t CHARACTER_ABILITY_COUNT = 6;
+
+class Character;
+
+// 场景中人物的二级索引：按状态的位集合、按所属势力的人物列表与按能力排序的索引。
+// 由 Scenario 建立，通过人物的 setter 修改时同步更新，查询的开销只与结果的大小有关。
+// 结果均为原始槽位，可用 Scenario::findCharacter 取得人物。
+class CharacterIndex
 {
 public:
-    Character(uint index, const Raw::Character& raw);
+    using SlotSet = bitset<MAX_CHARACTERS>;
+
+    void add(const Character& item);
 
-    void resolve(const ForcePtrVector& forces)
+    [[nodiscard]] const SlotSet& withStatus(const CharacterStatus status) const
     {
-        if (force_next_index < forces.size())
-        {
-            force_next = forces[force_next_index];
-        }
+        return statuses.at(static_cast<size_t>(status));
+    }
 
-        if (force_capture_index < forces.size())
-        {
-            force_or_capture = forces[force_capture_index];
-        }
+    // force_or_capture 为 force 的人物，按槽位排序；force 为势力的原始槽位，超出范围时为空
+    [[nodiscard]] span<const uint8_t> members(const uint8_t force) const
+    {
+        if (force >= MAX_FORCES) return {};
+        return forces[force];
+    }
 
-        if (force_before_capture_index < forces.size())
-        {
-            force_before_capture = forces[force_before_capture_index];
-        }
+    // 能力在 [min, max] 之间的人物，按能力从低到高排列，能力相同时按槽位
+    [[nodiscard]] vector<uint8_t> withAbility(CharacterAbility ability, uint8_t min, uint8_t max = 0xff) const;
+
+    void updateStatus(uint8_t slot, CharacterStatus before, CharacterStatus after);
+    void updateAbility(CharacterAbility ability, uint8_t slot, uint8_t before, uint8_t after);
+
+private:
+    array<SlotSet, CHARACTER_STATUS_COUNT> statuses;
+    array<vector<uint8_t>, MAX_FORCES> forces;
+    // 每项为 能力 << 8 | 槽位，保持升序
+    array<vector<uint16_t>, CHARACTER_ABILITY_COUNT> abilities;
+};
+
+class Character final : public NamedElement
+{
+public:
+    Character(uint index, const Raw::Character& raw);
+
+    void resolve(const EntityTables& tables)
+    {
+        force_next = optional_ptr(tables.force(force_next_index));
+        force_or_capture = optional_ptr(tables.force(force_capture_index));
+        force_before_capture = optional_ptr(tables.force(force_before_capture_index));
+        resolveStatus();
     }
 
+    // 由状态、所属势力和登场月数生成 status_string；resolve 和相关 setter 会自动调用
     const wstring& resolveStatus()
     {
         switch (status)
@@ -465,7 +783,7 @@ public:
 
     [[nodiscard]] const wstring& getAlias() const
     {
-        return alias;
+        return *alias;
     }
 
     [[nodiscard]] uint8_t getSiegeAbility() const
@@ -498,11 +816,37 @@ public:
         return politics;
     }
 
+    [[nodiscard]] uint8_t getAbility(const CharacterAbility ability) const
+    {
+        switch (ability)
+        {
+        case CharacterAbility::Siege:
+            return siege_ability;
+        case CharacterAbility::Field:
+            return field_ability;
+        case CharacterAbility::Naval:
+            return naval_ability;
+        case CharacterAbility::Battle:
+            return battle_ability;
+        case CharacterAbility::Command:
+            return command;
+        case CharacterAbility::Politics:
+            return politics;
+        }
+        return 0;
+    }
+
     [[nodiscard]] const CharacterStatus& getStatus() const
     {
         return status;
     }
 
+    // 原始的 force_or_capture，MAX_FORCES 及以上表示无
+    [[nodiscard]] uint8_t getForceCaptureSlot() const
+    {
+        return force_capture_index;
+    }
+
     [[nodiscard]] uint8_t getMonthToBoard() const
     {
         return month_to_board;
@@ -538,10 +882,75 @@ public:
         return to_board;
     }
 
+    void setName(const wstring& value)
+    {
+        assignName(value, sizeof(Raw::Name::name));
+    }
+
+    void setAlias(const wstring& value)
+    {
+        alias = &intern_encoded_name(value, sizeof(Raw::Name::name));
+        markDirty();
+    }
+
+    void setSiegeAbility(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Siege, siege_ability, value);
+    }
+
+    void setFieldAbility(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Field, field_ability, value);
+    }
+
+    void setNavalAbility(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Naval, naval_ability, value);
+    }
+
+    void setBattleAbility(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Battle, battle_ability, value);
+    }
+
+    void setCommand(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Command, command, value);
+    }
+
+    void setPolitics(const uint8_t value)
+    {
+        assignAbility(CharacterAbility::Politics, politics, value);
+    }
+
+    void setStatus(const CharacterStatus value)
+    {
+        if (character_index) character_index->updateStatus(getIndex(), status, value);
+        status = value;
+        resolveStatus();
+        markDirty();
+    }
+
+    void setMonthToBoard(const uint8_t value)
+    {
+        month_to_board = value;
+        resolveStatus();
+        markDirty();
+    }
+
 private:
+    friend class Scenario;
+
+    void assignAbility(const CharacterAbility ability, uint8_t& field, const uint8_t value)
+    {
+        if (character_index) character_index->updateAbility(ability, getIndex(), field, value);
+        field = value;
+        markDirty();
+    }
+
     uint8_t property;
     uint8_t avatar;
-    wstring alias;
+    const wstring* alias;
     uint8_t siege_ability;
     uint8_t field_ability;
     uint8_t naval_ability;
@@ -560,19 +969,99 @@ private:
     bool to_suicide;
     bool is_warlord;
     bool to_board;
+    // 所在场景的索引，由 Scenario 设置；单独构建的人物没有索引
+    CharacterIndex* character_index = nullptr;
 };
 
 class City final : public NamedElement
 {
 public:
-    City(uint index, const Raw::City& raw, const CharacterPtrVector& characters);
+    // tables 中的人物必须已经构建
+    City(uint index, const Raw::City& raw, const EntityTables& tables);
 
-    void resolve(const ForcePtrVector& forces)
+    void resolve(const EntityTables& tables)
     {
-        if (force_index < forces.size())
-        {
-            force = forces[force_index];
-        }
+        force = optional_ptr(tables.force(force_index));
+    }
+
+    [[nodiscard]] const Force* getForce() const
+    {
+        return force.value_or(nullptr).get();
+    }
+
+    [[nodiscard]] const Axis& getAxis() const
+    {
+        return axis;
+    }
+
+    [[nodiscard]] uint16_t getMaxProductivity() const
+    {
+        return max_productivity;
+    }
+
+    [[nodiscard]] uint16_t getCurProductivity() const
+    {
+        return cur_productivity;
+    }
+
+    [[nodiscard]] uint8_t getIncrease() const
+    {
+        return increase;
+    }
+
+    [[nodiscard]] uint8_t getAntiDisaster() const
+    {
+        return anti_disaster;
+    }
+
+    [[nodiscard]] uint8_t getSoldiers() const
+    {
+        return soldiers;
+    }
+
+    [[nodiscard]] uint16_t getCityType() const
+    {
+        return city_type;
+    }
+
+    [[nodiscard]] const Character* getAffairsOwner() const
+    {
+        return affairs_owner.value_or(nullptr).get();
+    }
+
+    void setName(const wstring& value)
+    {
+        assignName(value, sizeof(Raw::Name::name));
+    }
+
+    void setMaxProductivity(const uint16_t value)
+    {
+        max_productivity = value;
+        markDirty();
+    }
+
+    void setCurProductivity(const uint16_t value)
+    {
+        cur_productivity = value;
+        markDirty();
+    }
+
+    void setIncrease(const uint8_t value)
+    {
+        increase = value;
+        markDirty();
+    }
+
+    void setAntiDisaster(const uint8_t value)
+    {
+        anti_disaster = value;
+        markDirty();
+    }
+
+    void setSoldiers(const uint8_t value)
+    {
+        soldiers = value;
+        markDirty();
     }
 
 private:
@@ -592,10 +1081,84 @@ private:
 class Legion final : public NamedElement
 {
 public:
-    Legion(uint index, const Raw::Legion& raw, const ForcePtrVector& forces, const CharacterPtrVector& characters,
-           const CityPtrVector& cities);
+    // tables 中的势力、人物与城市必须已经构建；指向空槽位的关联为空指针
+    Legion(uint index, const Raw::Legion& raw, const EntityTables& tables);
+
+    [[nodiscard]] uint8_t getState() const
+    {
+        return state;
+    }
+
+    [[nodiscard]] const Force* getForce() const
+    {
+        return force.get();
+    }
+
+    [[nodiscard]] const Character* getLeader() const
+    {
+        return leader.get();
+    }
+
+    [[nodiscard]] const City* getTargetCity() const
+    {
+        return target_city.get();
+    }
+
+    [[nodiscard]] uint16_t getTotalSoldier() const
+    {
+        return total_soldier;
+    }
+
+    [[nodiscard]] uint8_t getMorale() const
+    {
+        return morale;
+    }
+
+    [[nodiscard]] const Axis& getCurrentAxis() const
+    {
+        return current_axis;
+    }
+
+    [[nodiscard]] const Axis& getTargetAxis() const
+    {
+        return target_axis;
+    }
+
+    [[nodiscard]] const vector<Troop>& getTroops() const
+    {
+        return troops;
+    }
+
+    void setTotalSoldier(const uint16_t value)
+    {
+        total_soldier = value;
+        markDirty();
+    }
+
+    void setMorale(const uint8_t value)
+    {
+        morale = value;
+        markDirty();
+    }
+
+    // 坐标为 0 的军团视为空槽位，因此 x 与 y 都不能为 0
+    void setCurrentAxis(const Raw::Axis& value)
+    {
+        if (value.x == 0 || value.y == 0) throw out_of_range("legion axis must not be zero");
+        if (legion_grid) legion_grid->move(getIndex(), current_axis.x, current_axis.y, value.x, value.y);
+        current_axis = Axis(value);
+        markDirty();
+    }
+
+    void setTargetAxis(const Raw::Axis& value)
+    {
+        target_axis = Axis(value);
+        markDirty();
+    }
 
 private:
+    friend class Scenario;
+
     uint8_t state;
     ForcePtr force;
     CharacterPtr leader;
@@ -605,6 +1168,8 @@ private:
     Axis current_axis;
     Axis target_axis;
     vector<Troop> troops;
+    // 所在场景按当前位置建立的网格，由 Scenario 设置
+    SpatialGrid* legion_grid = nullptr;
 };
 
 class Conscription final
@@ -627,12 +1192,9 @@ class GameData
 public:
     explicit GameData(const Raw::GameData& raw);
 
-    void resolve(const ForcePtrVector& forces)
+    void resolve(const EntityTables& tables)
     {
-        if (force_index < forces.size())
-        {
-            force = forces[force_index];
-        }
+        force = optional_ptr(tables.force(force_index));
     }
 
     [[nodiscard]] uint8_t getDay() const
@@ -692,10 +1254,53 @@ public:
 
     [[nodiscard]] const wstring& getName() const
     {
-        return name;
+        return *name;
+    }
+
+    [[nodiscard]] bool isDirty() const
+    {
+        return dirty;
+    }
+
+    void clearDirty()
+    {
+        dirty = false;
+    }
+
+    void setDate(const uint16_t new_year, const uint8_t new_month, const uint8_t new_day)
+    {
+        year = new_year;
+        month = new_month;
+        day = new_day;
+        dirty = true;
+    }
+
+    void setTrust(const uint8_t value)
+    {
+        trust = value;
+        dirty = true;
+    }
+
+    void setCurTaxRate(const uint16_t value)
+    {
+        cur_tax_rate = value;
+        dirty = true;
+    }
+
+    void setNextTaxRate(const uint16_t value)
+    {
+        next_tax_rate = value;
+        dirty = true;
+    }
+
+    void setName(const wstring& value)
+    {
+        name = &intern_encoded_name(value, sizeof(Raw::GameData::name));
+        dirty = true;
     }
 
 private:
+    bool dirty = false;
     uint8_t day;
     uint8_t month;
     uint16_t year;
@@ -708,7 +1313,7 @@ private:
     uint16_t next_tax_rate;
     Conscription next_conscription;
     uint8_t total_forces;
-    wstring name;
+    const wstring* name;
 };
 
 class Scenario
@@ -718,16 +1323,16 @@ public:
 
     void resolve()
     {
-        game_data.resolve(forces);
+        game_data.resolve(tables);
 
-        for (const auto& item : cities)
+        for (const auto& item : tables.cities)
         {
-            item->resolve(forces);
+            item->resolve(tables);
         }
 
-        for (const auto& item : characters)
+        for (const auto& item : tables.characters)
         {
-            item->resolve(forces);
+            item->resolve(tables);
         }
     }
 
@@ -736,38 +1341,234 @@ public:
         return game_data;
     }
 
-    [[nodiscard]] const ForcePtrVector& getForces() const
+    [[nodiscard]] GameData& getGameData()
+    {
+        return game_data;
+    }
+
+    [[nodiscard]] ConstPtrView<Force> getForces() const
+    {
+        return ConstPtrView(tables.forces);
+    }
+
+    [[nodiscard]] ConstPtrView<City> getCities() const
+    {
+        return ConstPtrView(tables.cities);
+    }
+
+    [[nodiscard]] ConstPtrView<Legion> getLegions() const
+    {
+        return ConstPtrView(tables.legions);
+    }
+
+    [[nodiscard]] ConstPtrView<Character> getCharacters() const
+    {
+        return ConstPtrView(tables.characters);
+    }
+
+    // 可写的场景才能取得可修改的实体
+    [[nodiscard]] const ForcePtrVector& getForces()
+    {
+        return tables.forces;
+    }
+
+    [[nodiscard]] const CityPtrVector& getCities()
+    {
+        return tables.cities;
+    }
+
+    [[nodiscard]] const LegionPtrVector& getLegions()
+    {
+        return tables.legions;
+    }
+
+    [[nodiscard]] const CharacterPtrVector& getCharacters()
+    {
+        return tables.characters;
+    }
+
+    // 按原始槽位查找，O(1)；空槽位或超出范围时返回 nullptr
+    [[nodiscard]] const Character* findCharacter(const uint8_t slot) const
+    {
+        return tables.character(slot).get();
+    }
+
+    [[nodiscard]] const City* findCity(const uint8_t slot) const
+    {
+        return tables.city(slot).get();
+    }
+
+    [[nodiscard]] const Force* findForce(const uint8_t slot) const
+    {
+        return tables.force(slot).get();
+    }
+
+    [[nodiscard]] const CharacterIndex& getCharacterIndex() const
     {
-        return forces;
+        return *character_index;
     }
 
-    [[nodiscard]] const CityPtrVector& getCities() const
+    // 城市坐标与军团当前位置的网格，结果为原始槽位
+    [[nodiscard]] const SpatialGrid& getCityGrid() const
     {
-        return cities;
+        return city_grid;
     }
 
-    [[nodiscard]] const LegionPtrVector& getLegions() const
+    [[nodiscard]] const SpatialGrid& getLegionGrid() const
     {
-        return legions;
+        return *legion_grid;
     }
 
-    [[nodiscard]] const CharacterPtrVector& getCharacters() const
+    // 距离 (x, y) 最近的城市，没有城市时返回 nullptr
+    [[nodiscard]] const City* nearestCity(const uint16_t x, const uint16_t y) const
     {
-        return characters;
+        const auto slot = city_grid.nearest(x, y);
+        return slot ? findCity(*slot) : nullptr;
     }
 
 private:
     GameData game_data;
-    ForcePtrVector forces;
-    CityPtrVector cities;
-    LegionPtrVector legions;
-    CharacterPtrVector characters;
+    EntityTables tables;
+    // 人物与军团保存它们的地址，场景移动时地址不变
+    unique_ptr<CharacterIndex> character_index;
+    // 城市都在 370 × 248 以内；军团坐标的范围大得多，使用更大的格子
+    SpatialGrid city_grid{4};
+    unique_ptr<SpatialGrid> legion_grid;
+};
+
+class RawFileImage;
+typedef shared_ptr<const RawFileImage> RawFileImagePtr;
+
+enum class ImageMode
+{
+    Map = 0,  // 完整大小的文件以只读内存映射读取，不做拷贝
+    Copy = 1, // 读入私有的堆缓冲区；游戏会原地改写或截断的存档使用，映像不随文件变化
+};
+
+class ScenarioPool;
+typedef shared_ptr<ScenarioPool> ScenarioPoolPtr;
+
+enum class LoadMode
+{
+    Eager = 0, // 加载文件时构建全部场景
+    Lazy = 1,  // 首次访问某个场景时才构建
+};
+
+// 一个场景文件中的场景列表，按需从文件映像构建 Scenario。
+// 多个线程同时访问同一场景时只会构建一次。
+class ScenarioList
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Scenario;
+        using difference_type = ptrdiff_t;
+        using pointer = const Scenario*;
+        using reference = const Scenario&;
+
+        const_iterator() = default;
+
+        const_iterator(const ScenarioList* list, const size_t index)
+            : list(list)
+              , index(index)
+        {
+        }
+
+        reference operator*() const
+        {
+            return (*list)[index];
+        }
+
+        pointer operator->() const
+        {
+            return &(*list)[index];
+        }
+
+        const_iterator& operator++()
+        {
+            ++index;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto old = *this;
+            ++index;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const = default;
+
+    private:
+        const ScenarioList* list = nullptr;
+        size_t index = 0;
+    };
+
+    ScenarioList() = default;
+    // 提供 pool 时，内容相同的场景与其它文件共享同一份只读的 Scenario
+    explicit ScenarioList(RawFileImagePtr image, ScenarioPoolPtr pool = nullptr);
+
+    const Scenario& operator[](size_t index) const;
+
+    // 取得可修改的场景，同一文件的所有副本共享已构建的场景。
+    // 场景来自 pool 时先从文件映像构建本文件私有的一份，之前取得的只读引用仍然有效但不再反映修改；
+    // 尚未构建时直接构建私有的一份。只读访问请用 operator[]，不会脱离 pool。
+    Scenario& edit(size_t index);
+
+    [[nodiscard]] size_t size() const
+    {
+        return state ? Raw::SCENARIO_COUNT : 0;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return size() == 0;
+    }
+
+    [[nodiscard]] bool isMaterialized(size_t index) const;
+
+    // 场景已构建且与其它文件共享（尚未复制出私有的一份）
+    [[nodiscard]] bool isShared(size_t index) const;
+
+    [[nodiscard]] const_iterator begin() const
+    {
+        return {this, 0};
+    }
+
+    [[nodiscard]] const_iterator end() const
+    {
+        return {this, size()};
+    }
+
+private:
+    struct State
+    {
+        RawFileImagePtr image;
+        ScenarioPoolPtr pool;
+        // current 指向 owned（私有）或 shared（来自 pool）
+        array<atomic<const Scenario*>, Raw::SCENARIO_COUNT> current{};
+        array<shared_ptr<const Scenario>, Raw::SCENARIO_COUNT> shared;
+        array<shared_ptr<Scenario>, Raw::SCENARIO_COUNT> owned;
+        array<once_flag, Raw::SCENARIO_COUNT> built;
+        mutex detach_mutex;
+    };
+
+    shared_ptr<State> state;
 };
 
 class ScenarioFile
 {
 public:
+    explicit ScenarioFile(const LoadMode mode = LoadMode::Eager, ScenarioPoolPtr pool = nullptr)
+        : load_mode(mode)
+          , pool(std::move(pool))
+    {
+    }
+
     virtual ~ScenarioFile() = default;
+    // 文件大小不符或未通过 is_valid_file 检查时返回 false，可用 validate_file 取得具体问题
     virtual bool loadFile(const fs::path& filepath);
 
     [[nodiscard]] const fs::path& getPath() const
@@ -775,32 +1576,110 @@ public:
         return file_path;
     }
 
-    [[nodiscard]] const std::vector<Scenario>& getScenarios() const
+    [[nodiscard]] LoadMode getLoadMode() const
+    {
+        return load_mode;
+    }
+
+    [[nodiscard]] const ScenarioList& getScenarios() const
     {
         return scenarios;
     }
 
+    [[nodiscard]] ScenarioList& getScenarios()
+    {
+        return scenarios;
+    }
+
+    // 只解析场景头部，不构建任何人物、城市、势力和军团；势力引用保持未解析状态。
+    // 文件未加载或 index 越界时抛出 std::out_of_range
+    [[nodiscard]] GameData readGameData(size_t index) const;
+
+    [[nodiscard]] const RawFileImagePtr& getImage() const
+    {
+        return image;
+    }
+
+protected:
+    // loadFile 的实现，以 mode 打开文件映像
+    bool load(const fs::path& filepath, ImageMode mode);
+
 private:
     fs::path file_path;
-    std::vector<Scenario> scenarios;
+    LoadMode load_mode;
+    ScenarioPoolPtr pool;
+    RawFileImagePtr image;
+    ScenarioList scenarios;
 };
 
 class SavedScenarioFile final : public ScenarioFile
 {
 public:
+    using ScenarioFile::ScenarioFile;
+
     ~SavedScenarioFile() override = default;
+    // 游戏运行时会原地改写存档，文件读入私有副本（ImageMode::Copy），改写或截断不影响已加载的场景
     bool loadFile(const fs::path& filepath) override;
 
+    // 加载时文件的修改时间
+    [[nodiscard]] fs::file_time_type getTimestamp() const
+    {
+        return timestamp;
+    }
+
 private:
     fs::file_time_type timestamp;
 };
 
+enum class ScanFileKind
+{
+    Scenario = 0,    // SINARIO/*.DAT
+    Saved = 1,       // SAVES/*.DAT
+    DefaultSave = 2, // SAVE.DAT
+};
+
+struct ScanOptions
+{
+    LoadMode mode = LoadMode::Eager;
+    // 解析文件的线程数，0 表示使用硬件并发数
+    size_t threads = 0;
+    // 请求取消后尚未开始的文件不再解析，openGameFolder 返回 false 且不修改已加载的内容
+    stop_token stop;
+    // 每个文件解析完成后调用，done 为已完成的文件数
+    function<void(size_t done, size_t total)> on_progress;
+    // 按确定的顺序（场景文件、存档、SAVE.DAT，各自按路径排序）逐个交付解析成功的文件
+    function<void(const ScenarioFile& file, ScanFileKind kind)> on_file;
+    // 内容相同的场景在所有文件间只构建一份
+    bool share_scenarios = true;
+};
+
+class BlockIndex;
+
 class DragonGameObject
 {
 public:
-    bool openGameFolder(string& folder_path);
+    // 回调在工作线程中串行调用，不得抛出异常
+    bool openGameFolder(string& folder_path, const ScanOptions& options = {});
+    // 以存档在磁盘上的内容原子地替换游戏目录的 SAVE.DAT；内存中尚未保存的修改需先经 ScenarioWriter::saveFile 写入
     [[nodiscard]] bool applySavedFile(const SavedScenarioFile& saved_file) const;
 
+    // 用重新加载的存档（kind 为 Saved）或 SAVE.DAT（kind 为 DefaultSave）替换路径相同的文件，
+    // 没有时按路径顺序插入。只更新这一个文件的块索引，不重新扫描文件夹
+    void putSavedFile(SavedScenarioFile file, ScanFileKind kind);
+    // 移除路径为 path 的存档或 SAVE.DAT，返回是否存在
+    bool removeSavedFile(const fs::path& path);
+
+    [[nodiscard]] const fs::path& get_game_folder_path() const
+    {
+        return gameFolderPath;
+    }
+
+    // openGameFolder 使用的加载模式，重新加载的文件沿用此模式
+    [[nodiscard]] LoadMode get_load_mode() const
+    {
+        return load_mode;
+    }
+
     [[nodiscard]] const std::vector<ScenarioFile>& get_scenario_files() const
     {
         return scenario_files;
@@ -816,8 +1695,25 @@ public:
         return default_saved_file;
     }
 
+    // 已加载文件中所有数据块的内容索引，文件夹未打开时为空指针
+    [[nodiscard]] const shared_ptr<const BlockIndex>& get_block_index() const
+    {
+        return block_index;
+    }
+
+    // share_scenarios 关闭时为空指针
+    [[nodiscard]] const ScenarioPoolPtr& get_scenario_pool() const
+    {
+        return scenario_pool;
+    }
+
 private:
+    void replaceIndexedImage(const RawFileImagePtr& removed, const RawFileImagePtr& added);
+
     fs::path gameFolderPath;
+    LoadMode load_mode = LoadMode::Eager;
+    ScenarioPoolPtr scenario_pool;
+    shared_ptr<const BlockIndex> block_index;
     std::vector<ScenarioFile> scenario_files;
     std::vector<SavedScenarioFile> saved_files;
     SavedScenarioFile default_saved_file;
@@ -0,0 +1,364 @@
+#include "ColumnarTable.h"
+#include "DragonData.h"
+#include "Exporter.h"
+#include "Query.h"
+#include "RawFileImage.h"
+#include "ScenarioDiff.h"
+#include "ScenarioStore.h"
+#include "ScenarioValidator.h"
+#include <benchmark/benchmark.h>
+#include <boost/locale.hpp>
+#include <sstream>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+// 运行方式：DragonDataBench --benchmark_out=result.json --benchmark_out_format=json
+// 在包含 tests 目录的工作目录下运行；合成的游戏目录生成在系统临时目录中。
+
+namespace
+{
+    fs::path data_path()
+    {
+        return fs::current_path() / "tests";
+    }
+
+    const std::vector<fs::path>& fixture_files()
+    {
+        static const std::vector<fs::path> files = []
+        {
+            std::vector<fs::path> result;
+            for (const auto* name : {"SINARIO-01.DAT", "SINARIO-02.DAT", "SINARIO-03.DAT", "SINARIO-04.DAT",
+                                     "SINARIO-05.DAT", "SINARIO-06.DAT", "SAVE.DAT"})
+            {
+                result.push_back(data_path() / name);
+            }
+            return result;
+        }();
+        return files;
+    }
+
+    // 生成包含 count 份存档副本的游戏目录，同一进程内复用
+    fs::path synthetic_folder(const size_t count)
+    {
+        auto root = fs::temp_directory_path() / ("DragonDataBench_" + std::to_string(count));
+        if (fs::exists(root / "SAVE.DAT")) return root;
+
+        fs::remove_all(root);
+        fs::create_directories(root / "SINARIO");
+        fs::create_directories(root / "SAVES");
+        const auto& files = fixture_files();
+        for (size_t i = 0; i < 6; ++i)
+        {
+            fs::copy_file(files[i], root / "SINARIO" / files[i].filename());
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            fs::copy_file(files[i % files.size()], root / "SAVES" / ("SAVE" + std::to_string(i) + ".DAT"));
+        }
+        fs::copy_file(files.back(), root / "SAVE.DAT");
+        return root;
+    }
+
+    const Raw::Scenario& fixture_scenario()
+    {
+        static const auto image = RawFileImage::open(data_path() / "SAVE.DAT");
+        return image->getScenario(0);
+    }
+}
+
+// 每次迭代读取不同的文件副本
+static void BM_LoadFileCold(benchmark::State& state)
+{
+    const auto folder = synthetic_folder(256) / "SAVES";
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        ScenarioFile file(static_cast<LoadMode>(state.range(0)));
+        benchmark::DoNotOptimize(file.loadFile(folder / ("SAVE" + std::to_string(i++ % 256) + ".DAT")));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Raw::FILE_SIZE));
+}
+
+BENCHMARK(BM_LoadFileCold)->ArgName("lazy")->Arg(0)->Arg(1);
+
+// 反复读取同一文件
+static void BM_LoadFileWarm(benchmark::State& state)
+{
+    const auto path = data_path() / "SAVE.DAT";
+    for (auto _ : state)
+    {
+        ScenarioFile file(static_cast<LoadMode>(state.range(0)));
+        benchmark::DoNotOptimize(file.loadFile(path));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Raw::FILE_SIZE));
+}
+
+BENCHMARK(BM_LoadFileWarm)->ArgName("lazy")->Arg(0)->Arg(1);
+
+static void BM_MapFile(benchmark::State& state)
+{
+    const auto path = data_path() / "SAVE.DAT";
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(RawFileImage::open(path));
+    }
+}
+
+BENCHMARK(BM_MapFile);
+
+static void BM_ConstructScenario(benchmark::State& state)
+{
+    const auto& raw = fixture_scenario();
+    for (auto _ : state)
+    {
+        Scenario scenario(raw);
+        benchmark::DoNotOptimize(scenario.getCharacters().data());
+    }
+}
+
+BENCHMARK(BM_ConstructScenario);
+
+static void BM_ConstructScenarioStore(benchmark::State& state)
+{
+    const auto& raw = fixture_scenario();
+    for (auto _ : state)
+    {
+        ScenarioStore store(raw);
+        benchmark::DoNotOptimize(store.getCharacters().count);
+    }
+}
+
+BENCHMARK(BM_ConstructScenarioStore);
+
+static void BM_ReadGameData(benchmark::State& state)
+{
+    ScenarioFile file(LoadMode::Lazy);
+    file.loadFile(data_path() / "SAVE.DAT");
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+        {
+            benchmark::DoNotOptimize(file.readGameData(i).getYear());
+        }
+    }
+}
+
+BENCHMARK(BM_ReadGameData);
+
+// 逐个解码全部人物名：0 = boost::locale，1 = 查表解码，2 = 驻留表
+static void BM_DecodeNames(benchmark::State& state)
+{
+    const auto& raw = fixture_scenario();
+    for (auto _ : state)
+    {
+        for (const auto& character : raw.characters)
+        {
+            const auto& name = character.name.name;
+            switch (state.range(0))
+            {
+            case 0:
+                benchmark::DoNotOptimize(
+                    boost::locale::conv::to_utf<wchar_t>(std::string(name, std::size(name)), "BIG5"));
+                break;
+            case 1:
+                benchmark::DoNotOptimize(name_to_utf8(name, std::size(name)));
+                break;
+            default:
+                benchmark::DoNotOptimize(&intern_name(name, std::size(name)));
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(raw.characters)));
+}
+
+BENCHMARK(BM_DecodeNames)->ArgName("method")->Arg(0)->Arg(1)->Arg(2);
+
+static void BM_ScanFolder(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    auto folder = synthetic_folder(count).string();
+    ScanOptions options;
+    options.mode = static_cast<LoadMode>(state.range(1));
+    options.threads = static_cast<size_t>(state.range(2));
+    for (auto _ : state)
+    {
+        DragonGameObject game;
+        benchmark::DoNotOptimize(game.openGameFolder(folder, options));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (count + 7)));
+}
+
+BENCHMARK(BM_ScanFolder)
+    ->ArgNames({"files", "lazy", "threads"})
+    ->ArgsProduct({{16, 256}, {0, 1}, {1, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_DumpScenarioFile(benchmark::State& state)
+{
+    ScenarioFile file;
+    file.loadFile(data_path() / "SAVE.DAT");
+    for (auto _ : state)
+    {
+        std::wstringstream ss;
+        ss << file;
+        benchmark::DoNotOptimize(ss.str().size());
+    }
+}
+
+BENCHMARK(BM_DumpScenarioFile);
+
+// 与 BM_DumpScenarioFile 对比：arg 0 为 JSON Lines，1 为人物表 CSV
+static void BM_ExportScenarioFile(benchmark::State& state)
+{
+    ScenarioFile file;
+    file.loadFile(data_path() / "SAVE.DAT");
+    std::string result;
+    result.reserve(4 << 20);
+    for (auto _ : state)
+    {
+        result.clear();
+        OutputBuffer out(result);
+        Exporter exporter(out, state.range(0) ? ExportFormat::Csv : ExportFormat::JsonLines,
+                          state.range(0) ? ExportTable::Characters : ExportTable::All);
+        exporter.write(file);
+        out.flush();
+        benchmark::DoNotOptimize(result.size());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * result.size()));
+}
+
+BENCHMARK(BM_ExportScenarioFile)->ArgName("csv")->Arg(0)->Arg(1);
+
+// 把 count 份存档的人物表写成列式表后，按列统计统率总和
+static void BM_ColumnarScan(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    const auto path = fs::temp_directory_path() / ("DragonDataBench_characters_" + std::to_string(count) + ".col");
+    {
+        const auto image = RawFileImage::open(data_path() / "SAVE.DAT");
+        ColumnarWriter writer(BlockKind::Characters);
+        for (size_t i = 0; i < count; ++i)
+        {
+            writer.add(image->getScenario(i % Raw::SCENARIO_COUNT));
+        }
+        writer.write(path);
+    }
+
+    const auto table = ColumnarTable::open(path);
+    const auto command = table->column<uint8_t>("command");
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (const auto value : command)
+        {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * command.size()));
+}
+
+BENCHMARK(BM_ColumnarScan)->ArgName("scenarios")->Arg(1024)->Arg(16384);
+
+// arg 0 只判断是否有错误，1 收集全部问题（包括警告）
+static void BM_ValidateFile(benchmark::State& state)
+{
+    const auto image = RawFileImage::open(data_path() / "SAVE.DAT");
+    std::vector<ValidationIssue> issues;
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            issues.clear();
+            benchmark::DoNotOptimize(validate_file(image->getFile(), issues));
+        }
+        else
+        {
+            benchmark::DoNotOptimize(is_valid_file(image->getFile()));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_ValidateFile)->ArgName("collect")->Arg(0)->Arg(1);
+
+// 存档与原始场景的差异：arg 0 为相同文件，1 为 SAVE.DAT 对 SINARIO-01.DAT
+static void BM_DiffFiles(benchmark::State& state)
+{
+    const auto source = RawFileImage::open(data_path() / "SINARIO-01.DAT");
+    const auto target = RawFileImage::open(data_path() / (state.range(0) ? "SAVE.DAT" : "SINARIO-01.DAT"));
+    std::vector<FieldChange> changes;
+    for (auto _ : state)
+    {
+        changes.clear();
+        benchmark::DoNotOptimize(diff_files(source->getFile(), target->getFile(), changes));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sizeof(Raw::File)));
+    state.counters["changes"] = static_cast<double>(changes.size());
+}
+
+BENCHMARK(BM_DiffFiles)->ArgName("changed")->Arg(0)->Arg(1);
+
+// 筛选空闲且统率高的人物：arg 0 直接在 Raw 记录上求值，1 先构建对象再遍历
+static void BM_QueryCharacters(benchmark::State& state)
+{
+    const auto query = Query(BlockKind::Characters)
+                       .where("status", CompareOp::Equal, static_cast<int>(CharacterStatus::Idle))
+                       .where("command", CompareOp::Greater, 10)
+                       .where("month_to_board", CompareOp::LessEqual, 3)
+                       .select("name");
+    ScenarioFile file(LoadMode::Lazy);
+    file.loadFile(data_path() / "SAVE.DAT");
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            ScenarioFile eager;
+            eager.loadFile(data_path() / "SAVE.DAT");
+            size_t count = 0;
+            for (const auto& scenario : eager.getScenarios())
+            {
+                for (const auto& c : scenario.getCharacters())
+                {
+                    if (c->getStatus() == CharacterStatus::Idle && c->getCommand() > 10 && c->getMonthToBoard() <= 3)
+                    {
+                        benchmark::DoNotOptimize(c->getName());
+                        ++count;
+                    }
+                }
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        else
+        {
+            benchmark::DoNotOptimize(query.run(file));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_QueryCharacters)->ArgName("objects")->Arg(0)->Arg(1);
+
+// 地图点击：在 SAVE.DAT 的一个场景中查找距离随机点最近的城市
+static void BM_NearestCity(benchmark::State& state)
+{
+    SavedScenarioFile file(LoadMode::Lazy);
+    file.loadFile(data_path() / "SAVE.DAT");
+    const auto& scenario = file.getScenarios()[2];
+    uint32_t seed = 1;
+    for (auto _ : state)
+    {
+        seed = seed * 1103515245 + 12345;
+        const auto x = static_cast<uint16_t>(seed >> 8 & 0x1ff);
+        const auto y = static_cast<uint16_t>(seed >> 20 & 0xff);
+        benchmark::DoNotOptimize(scenario.nearestCity(x, y));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_NearestCity);
+
+BENCHMARK_MAIN();
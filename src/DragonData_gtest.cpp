@@ -1,8 +1,10 @@
 // File: `src/DragonData_gtest.cpp`
 #include "DragonData.h"
+#include "BlockIndex.h"
 #include <gtest/gtest.h>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 using namespace DragonData;
 namespace fs = std::filesystem;
@@ -140,3 +142,222 @@ TEST(DragonData, LoadSaveFile)
     of << file;
     of.close();
 }
+
+TEST(DragonData, LazyLoadScenario)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file(LoadMode::Lazy);
+    EXPECT_TRUE(file.loadFile(data_path / "SINARIO-01.DAT"));
+    const auto& scenarios = file.getScenarios();
+    EXPECT_EQ(scenarios.size(), 4);
+    EXPECT_FALSE(scenarios.isMaterialized(0));
+
+    ScenarioFile eager;
+    EXPECT_TRUE(eager.loadFile(data_path / "SINARIO-01.DAT"));
+    EXPECT_EQ(file.readGameData(2).getName(), eager.getScenarios()[2].getGameData().getName());
+    EXPECT_FALSE(scenarios.isMaterialized(2));
+    EXPECT_THROW(file.readGameData(Raw::SCENARIO_COUNT), std::out_of_range);
+    EXPECT_THROW(ScenarioFile().readGameData(0), std::out_of_range);
+
+    const auto& scenario = scenarios[2];
+    EXPECT_TRUE(scenarios.isMaterialized(2));
+    EXPECT_FALSE(scenarios.isMaterialized(1));
+    EXPECT_EQ(&scenario, &scenarios[2]);
+    EXPECT_EQ(scenario.getCharacters().size(), eager.getScenarios()[2].getCharacters().size());
+}
+
+TEST(DragonData, OpenGameFolderParallel)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto game_path = fs::temp_directory_path() / "DragonData_game";
+    fs::remove_all(game_path);
+    fs::create_directories(game_path / "SINARIO");
+    fs::create_directories(game_path / "SAVES");
+    for (int i = 6; i >= 1; --i)
+    {
+        auto name = "SINARIO-0" + std::to_string(i) + ".DAT";
+        fs::copy_file(data_path / name, game_path / "SINARIO" / name);
+        fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVES" / ("SAVE" + std::to_string(i) + ".DAT"));
+    }
+    fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVE.DAT");
+
+    ScanOptions options;
+    options.mode = LoadMode::Lazy;
+    options.threads = 4;
+    std::vector<fs::path> delivered;
+    size_t last_done = 0;
+    options.on_file = [&](const ScenarioFile& file, ScanFileKind) { delivered.push_back(file.getPath()); };
+    options.on_progress = [&](size_t done, size_t total)
+    {
+        EXPECT_EQ(done, last_done + 1);
+        EXPECT_EQ(total, 13);
+        last_done = done;
+    };
+
+    DragonGameObject game;
+    auto folder = game_path.string();
+    ASSERT_TRUE(game.openGameFolder(folder, options));
+    ASSERT_EQ(game.get_scenario_files().size(), 6);
+    ASSERT_EQ(game.get_saved_files().size(), 6);
+    EXPECT_EQ(game.get_default_saved_file().getScenarios().size(), 4);
+    EXPECT_EQ(game.get_scenario_files().front().getPath().filename(), "SINARIO-01.DAT");
+    ASSERT_EQ(delivered.size(), 13);
+    EXPECT_TRUE(std::is_sorted(delivered.begin(), delivered.begin() + 6));
+    EXPECT_EQ(delivered.back().filename(), "SAVE.DAT");
+    EXPECT_EQ(last_done, 13);
+
+    // 7 个相同的存档共享同一份场景
+    ASSERT_TRUE(game.get_block_index());
+    EXPECT_EQ(game.get_block_index()->blockCount(BlockKind::Scenario), 13 * 4);
+    EXPECT_EQ(&game.get_saved_files()[0].getScenarios()[1], &game.get_default_saved_file().getScenarios()[1]);
+    EXPECT_EQ(game.get_scenario_pool()->size(), 1);
+
+    std::stop_source stop;
+    stop.request_stop();
+    options.stop = stop.get_token();
+    options.on_file = nullptr;
+    options.on_progress = nullptr;
+    EXPECT_FALSE(game.openGameFolder(folder, options));
+    EXPECT_EQ(game.get_scenario_files().size(), 6);
+
+    fs::remove_all(game_path);
+}
+
+TEST(DragonData, ResolveSparseTables)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(data_path / "SAVE.DAT"));
+    auto raw = std::make_unique<Raw::Scenario>(file.getImage()->getScenario(0));
+
+    // 清空前面的槽位，之后的紧凑下标与原始槽位不再相同
+    for (size_t i = 0; i < 3; ++i)
+    {
+        raw->characters[i].name.name[0] = 0;
+        raw->cities[i].axis = {0, 0};
+    }
+    const auto first_force = std::find_if(std::begin(raw->forces), std::end(raw->forces),
+                                          [](const Raw::Force& f) { return f.status != 0; });
+    first_force->status = 0;
+
+    Scenario scenario(*raw);
+    ASSERT_EQ(scenario.getCharacters().size(), MAX_CHARACTERS - 3);
+    EXPECT_EQ(scenario.findCharacter(0), nullptr);
+    EXPECT_EQ(scenario.findCharacter(200), nullptr);
+    EXPECT_EQ(scenario.findCharacter(3), scenario.getCharacters()[0].get());
+
+    for (const auto& force : scenario.getForces())
+    {
+        const auto& item = raw->forces[force->getIndex()];
+        const auto* warlord = force->getWarlord();
+        if (item.warlord < 3)
+        {
+            EXPECT_EQ(warlord, nullptr);
+            continue;
+        }
+        ASSERT_NE(warlord, nullptr);
+        EXPECT_EQ(warlord->getIndex(), item.warlord);
+        EXPECT_EQ(force->getName(), warlord->getName());
+        if (const auto* capital = force->getCapital())
+        {
+            EXPECT_EQ(capital->getIndex(), item.capital);
+        }
+    }
+
+    for (const auto& legion : scenario.getLegions())
+    {
+        const auto& item = raw->legions[legion->getIndex()];
+        if (const auto* force = legion->getForce())
+        {
+            EXPECT_EQ(force->getIndex(), item.force);
+        }
+        if (const auto* leader = legion->getLeader())
+        {
+            EXPECT_EQ(leader->getIndex(), item.leader);
+        }
+    }
+
+    for (const auto& city : scenario.getCities())
+    {
+        const auto& item = raw->cities[city->getIndex()];
+        if (const auto* force = city->getForce())
+        {
+            EXPECT_EQ(force->getIndex(), item.force);
+        }
+        else
+        {
+            EXPECT_EQ(scenario.findForce(item.force), nullptr);
+        }
+    }
+
+    for (const auto& character : scenario.getCharacters())
+    {
+        const auto& item = raw->characters[character->getIndex()];
+        if (const auto* force = character->getForceCapture())
+        {
+            EXPECT_EQ(force->getIndex(), item.force_or_capture);
+        }
+        EXPECT_EQ(character->getForceCapture() == nullptr, scenario.findForce(item.force_or_capture) == nullptr);
+    }
+}
+
+TEST(DragonData, CharacterIndex)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(data_path / "SAVE.DAT"));
+    auto& scenario = file.getScenarios().edit(2);
+    const auto& index = scenario.getCharacterIndex();
+
+    const auto expect_consistent = [&]
+    {
+        for (size_t s = 0; s < CHARACTER_STATUS_COUNT; ++s)
+        {
+            CharacterIndex::SlotSet expected;
+            for (const auto& c : scenario.getCharacters())
+            {
+                if (c->getStatus() == static_cast<CharacterStatus>(s)) expected.set(c->getIndex());
+            }
+            EXPECT_EQ(index.withStatus(static_cast<CharacterStatus>(s)), expected) << s;
+        }
+
+        std::vector<uint8_t> expected;
+        for (const auto& c : scenario.getCharacters())
+        {
+            if (c->getCommand() >= 8 && c->getCommand() <= 12) expected.push_back(c->getIndex());
+        }
+        auto found = index.withAbility(CharacterAbility::Command, 8, 12);
+        for (size_t i = 1; i < found.size(); ++i)
+        {
+            EXPECT_LE(scenario.findCharacter(found[i - 1])->getCommand(),
+                      scenario.findCharacter(found[i])->getCommand());
+        }
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    };
+    expect_consistent();
+
+    size_t members = 0;
+    for (uint8_t force = 0; force < MAX_FORCES; ++force)
+    {
+        for (const auto slot : index.members(force))
+        {
+            EXPECT_EQ(scenario.findCharacter(slot)->getForceCaptureSlot(), force);
+            ++members;
+        }
+    }
+    EXPECT_EQ(members, std::count_if(scenario.getCharacters().begin(), scenario.getCharacters().end(),
+                                     [](const auto& c) { return c->getForceCaptureSlot() < MAX_FORCES; }));
+    EXPECT_TRUE(index.members(MAX_FORCES).empty());
+
+    // 通过 setter 修改后索引同步更新
+    const auto& first = scenario.getCharacters().front();
+    const auto& last = scenario.getCharacters().back();
+    first->setStatus(CharacterStatus::Diplomat);
+    first->setCommand(10);
+    last->setCommand(200);
+    last->setStatus(CharacterStatus::Idle);
+    expect_consistent();
+    EXPECT_EQ(index.withAbility(CharacterAbility::Command, 200), std::vector<uint8_t>{last->getIndex()});
+    EXPECT_TRUE(index.withAbility(CharacterAbility::Command, 12, 8).empty());
+}
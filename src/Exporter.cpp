@@ -0,0 +1,687 @@
+#include "Exporter.h"
+#include "RawLayout.h"
+#include "ScenarioWriter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    void write_fd(const int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+#ifdef _WIN32
+            const auto written = _write(fd, data, static_cast<unsigned>(min<size_t>(size, 1u << 30)));
+#else
+            const auto written = ::write(fd, data, size);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR) continue;
+                throw runtime_error("write export failed");
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    constexpr bool is_json_safe(const wchar_t c)
+    {
+        return c >= 0x20 && c != L'"' && c != L'\\';
+    }
+
+    constexpr bool is_csv_safe(const wchar_t c)
+    {
+        return c != L',' && c != L'"' && c != L'\n' && c != L'\r';
+    }
+
+    // JSON 字符串中需要转义的字符
+    void write_json_escape(OutputBuffer& out, const unsigned c)
+    {
+        static constexpr char HEX[] = "0123456789abcdef";
+        switch (c)
+        {
+        case '"':
+            out.write(R"(\")");
+            break;
+        case '\\':
+            out.write(R"(\\)");
+            break;
+        case '\n':
+            out.write(R"(\n)");
+            break;
+        default:
+            out.write(R"(\u00)");
+            out.put(HEX[c >> 4 & 0xf]);
+            out.put(HEX[c & 0xf]);
+            break;
+        }
+    }
+
+    // JSON Lines：,"name":value
+    class JsonVisitor
+    {
+    public:
+        explicit JsonVisitor(OutputBuffer& out)
+            : out(out)
+        {
+        }
+
+        void begin(const char* type)
+        {
+            out.write(R"({"type":")");
+            out.write(type);
+            out.put('"');
+        }
+
+        void end()
+        {
+            out.write("}\n");
+        }
+
+        void number(const char* name, const int64_t value)
+        {
+            key(name);
+            out.writeNumber(value);
+        }
+
+        void boolean(const char* name, const bool value)
+        {
+            key(name);
+            out.write(value ? "true" : "false");
+        }
+
+        void text(const char* name, const wstring_view value)
+        {
+            key(name);
+            out.writeJson(value);
+        }
+
+        // value 已经是 UTF-8
+        void utf8(const char* name, const string_view value)
+        {
+            key(name);
+            out.writeJson(value);
+        }
+
+        void reference(const char* name, const Element* value)
+        {
+            key(name);
+            if (value == nullptr)
+            {
+                out.write("null");
+            }
+            else
+            {
+                out.writeNumber(value->getIndex());
+            }
+        }
+
+    private:
+        void key(const char* name)
+        {
+            out.write(R"(,")");
+            out.write(name);
+            out.write(R"(":)");
+        }
+
+        OutputBuffer& out;
+    };
+
+    // CSV 表头：只输出字段名
+    class CsvHeaderVisitor
+    {
+    public:
+        explicit CsvHeaderVisitor(OutputBuffer& out)
+            : out(out)
+        {
+        }
+
+        void begin(const char*)
+        {
+            first = true;
+        }
+
+        void end()
+        {
+            out.write("\r\n");
+        }
+
+        void number(const char* name, int64_t)
+        {
+            key(name);
+        }
+
+        void boolean(const char* name, bool)
+        {
+            key(name);
+        }
+
+        void text(const char* name, wstring_view)
+        {
+            key(name);
+        }
+
+        void utf8(const char* name, string_view)
+        {
+            key(name);
+        }
+
+        void reference(const char* name, const Element*)
+        {
+            key(name);
+        }
+
+    private:
+        void key(const char* name)
+        {
+            if (!first) out.put(',');
+            first = false;
+            out.write(name);
+        }
+
+        OutputBuffer& out;
+        bool first = true;
+    };
+
+    // CSV 记录（RFC 4180）：含有分隔符、引号或换行的字段加引号，引号双写
+    class CsvVisitor
+    {
+    public:
+        explicit CsvVisitor(OutputBuffer& out)
+            : out(out)
+        {
+        }
+
+        void begin(const char*)
+        {
+            first = true;
+        }
+
+        void end()
+        {
+            out.write("\r\n");
+        }
+
+        void number(const char*, const int64_t value)
+        {
+            separator();
+            out.writeNumber(value);
+        }
+
+        void boolean(const char*, const bool value)
+        {
+            separator();
+            out.write(value ? "true" : "false");
+        }
+
+        void text(const char*, const wstring_view value)
+        {
+            separator();
+            if (all_of(value.begin(), value.end(), is_csv_safe))
+            {
+                out.writeUtf8(value);
+                return;
+            }
+            out.put('"');
+            size_t begin = 0;
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if (value[i] != L'"') continue;
+                out.writeUtf8(value.substr(begin, i + 1 - begin));
+                out.put('"');
+                begin = i + 1;
+            }
+            out.writeUtf8(value.substr(begin));
+            out.put('"');
+        }
+
+        void utf8(const char*, const string_view value)
+        {
+            separator();
+            if (value.find_first_of(",\"\r\n") == string_view::npos)
+            {
+                out.write(value);
+                return;
+            }
+            out.put('"');
+            for (const char c : value)
+            {
+                if (c == '"') out.put('"');
+                out.put(c);
+            }
+            out.put('"');
+        }
+
+        void reference(const char*, const Element* value)
+        {
+            separator();
+            if (value != nullptr) out.writeNumber(value->getIndex());
+        }
+
+    private:
+        void separator()
+        {
+            if (!first) out.put(',');
+            first = false;
+        }
+
+        OutputBuffer& out;
+        bool first = true;
+    };
+
+    struct TextColumn
+    {
+        const FieldInfo* field;
+        wstring_view value;
+    };
+
+    struct ReferenceColumn
+    {
+        const FieldInfo* field;
+        const Element* target;
+    };
+
+    // 在编译期按名字取字段，名字拼错时编译失败
+    template <typename R>
+    consteval const FieldInfo* column(const string_view name)
+    {
+        return &layout_field<R>(name);
+    }
+
+    // 数组字段各元素的列名 name[i]，与 Query、ColumnarWriter 的命名一致；首次使用时按字段表生成
+    template <typename R>
+    const string& element_name(const size_t field, const size_t element)
+    {
+        static const auto names = []
+        {
+            vector<vector<string>> result;
+            for (const auto& info : RecordLayout<R>::fields)
+            {
+                auto& elements = result.emplace_back();
+                for (size_t i = 0; info.count > 1 && i < info.count; ++i)
+                {
+                    elements.push_back(string(info.name) + "[" + to_string(i) + "]");
+                }
+            }
+            return result;
+        }();
+        return names[field][element];
+    }
+
+    // 按 R 的字段表顺序输出 raw 的全部字段：保留字段跳过，名字输出解码后的文本，
+    // 关联输出解析后的对象，其余数值字段输出原始值。texts 与 references 须按字段表中的顺序给出。
+    // 字段表在编译期展开，每列的类型与宽度都是常量
+    template <typename R, typename V>
+    void visit_layout(V& v, const R& raw, const initializer_list<TextColumn> texts,
+                      const initializer_list<ReferenceColumn> references)
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&raw);
+        auto text = texts.begin();
+        auto reference = references.begin();
+        const auto visit = [&]<size_t I>()
+        {
+            constexpr auto& field = RecordLayout<R>::fields[I];
+            if constexpr (field.type == FieldType::Name)
+            {
+                if (text != texts.end() && text->field == &field) v.text(field.name, (text++)->value);
+            }
+            else if constexpr (!field.isReserved())
+            {
+                if (reference != references.end() && reference->field == &field)
+                {
+                    v.reference(field.name, (reference++)->target);
+                }
+                else if constexpr (field.count == 1)
+                {
+                    v.number(field.name, read_field<field.type>(bytes + field.offset));
+                }
+                else
+                {
+                    for (size_t element = 0; element < field.count; ++element)
+                    {
+                        v.number(element_name<R>(I, element).c_str(),
+                                 read_field<field.type>(bytes + field.offset + element * field.stride));
+                    }
+                }
+            }
+        };
+        [&]<size_t... I>(index_sequence<I...>)
+        {
+            (visit.template operator()<I>(), ...);
+        }(make_index_sequence<size(RecordLayout<R>::fields)>());
+
+        if (text != texts.end() || reference != references.end())
+        {
+            throw logic_error("export columns are not in layout order");
+        }
+    }
+
+    template <typename V>
+    void visit_fields(V& v, const GameData& item, const Raw::GameData& raw)
+    {
+        visit_layout(v, raw, {{column<Raw::GameData>("name"), item.getName()}},
+                     {{column<Raw::GameData>("force"), item.getForce()}});
+    }
+
+    template <typename V>
+    void visit_fields(V& v, const Force& item, const Raw::Force& raw)
+    {
+        v.number("index", item.getIndex());
+        v.text("name", item.getName());
+        visit_layout(v, raw, {},
+                     {
+                         {column<Raw::Force>("warlord"), item.getWarlord()},
+                         {column<Raw::Force>("advisor"), item.getAdvisor()},
+                         {column<Raw::Force>("capital"), item.getCapital()},
+                         {column<Raw::Force>("diplomacy_owner"), item.getDiplomacyOwner()},
+                     });
+    }
+
+    template <typename V>
+    void visit_fields(V& v, const City& item, const Raw::City& raw)
+    {
+        v.number("index", item.getIndex());
+        visit_layout(v, raw, {{column<Raw::City>("name"), item.getName()}},
+                     {
+                         {column<Raw::City>("force"), item.getForce()},
+                         {column<Raw::City>("affairs_owner"), item.getAffairsOwner()},
+                     });
+    }
+
+    template <typename V>
+    void visit_fields(V& v, const Legion& item, const Raw::Legion& raw)
+    {
+        v.number("index", item.getIndex());
+        v.text("name", item.getName());
+        visit_layout(v, raw, {},
+                     {
+                         {column<Raw::Legion>("force"), item.getForce()},
+                         {column<Raw::Legion>("leader"), item.getLeader()},
+                         {column<Raw::Legion>("target_city"), item.getTargetCity()},
+                     });
+    }
+
+    template <typename V>
+    void visit_fields(V& v, const Character& item, const Raw::Character& raw)
+    {
+        v.number("index", item.getIndex());
+        visit_layout(v, raw,
+                     {
+                         {column<Raw::Character>("name"), item.getName()},
+                         {column<Raw::Character>("alias"), item.getAlias()},
+                     },
+                     {
+                         {column<Raw::Character>("force_next"), item.getForceNext()},
+                         {column<Raw::Character>("force_or_capture"), item.getForceCapture()},
+                         {column<Raw::Character>("force_origin"), item.getForceOrigin()},
+                     });
+        // 由状态与关联推导的字段
+        v.text("status_string", item.getStatusString());
+        v.boolean("to_suicide", item.isToSuicide());
+        v.boolean("is_warlord", item.isWarlord());
+        v.boolean("to_board", item.isToBoard());
+    }
+
+    template <typename V, typename T, typename R>
+    void visit_record(V& v, const char* type, const string& file, const size_t scenario, const T& item, const R& raw)
+    {
+        v.begin(type);
+        v.utf8("file", file);
+        v.number("scenario", static_cast<int64_t>(scenario));
+        visit_fields(v, item, raw);
+        v.end();
+    }
+}
+
+OutputBuffer::OutputBuffer(const int fd)
+    : buffer(make_unique<char[]>(BUFFER_SIZE))
+      , fd(fd)
+{
+}
+
+OutputBuffer::OutputBuffer(string& target)
+    : buffer(make_unique<char[]>(BUFFER_SIZE))
+      , target(&target)
+{
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // 析构时无法报告错误，需要确认写入结果时应先显式调用 flush
+    }
+}
+
+void OutputBuffer::write(string_view s)
+{
+    while (!s.empty())
+    {
+        if (used == BUFFER_SIZE) flush();
+        const auto n = min(s.size(), BUFFER_SIZE - used);
+        memcpy(buffer.get() + used, s.data(), n);
+        used += n;
+        s.remove_prefix(n);
+    }
+}
+
+void OutputBuffer::writeNumber(const int64_t value)
+{
+    char digits[24];
+    const auto result = to_chars(begin(digits), end(digits), value);
+    write({digits, static_cast<size_t>(result.ptr - digits)});
+}
+
+void OutputBuffer::writeUtf8(const wstring_view s)
+{
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        auto c = static_cast<char32_t>(s[i]);
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            // UTF-16 代理对
+            if (c >= 0xd800 && c < 0xdc00 && i + 1 < s.size() && s[i + 1] >= 0xdc00 && s[i + 1] < 0xe000)
+            {
+                c = 0x10000 + ((c - 0xd800) << 10) + (static_cast<char32_t>(s[++i]) - 0xdc00);
+            }
+        }
+
+        if (BUFFER_SIZE - used < 4) flush();
+        auto* p = buffer.get() + used;
+        if (c < 0x80)
+        {
+            *p++ = static_cast<char>(c);
+        }
+        else if (c < 0x800)
+        {
+            *p++ = static_cast<char>(0xc0 | c >> 6);
+            *p++ = static_cast<char>(0x80 | (c & 0x3f));
+        }
+        else if (c < 0x10000)
+        {
+            *p++ = static_cast<char>(0xe0 | c >> 12);
+            *p++ = static_cast<char>(0x80 | (c >> 6 & 0x3f));
+            *p++ = static_cast<char>(0x80 | (c & 0x3f));
+        }
+        else
+        {
+            *p++ = static_cast<char>(0xf0 | c >> 18);
+            *p++ = static_cast<char>(0x80 | (c >> 12 & 0x3f));
+            *p++ = static_cast<char>(0x80 | (c >> 6 & 0x3f));
+            *p++ = static_cast<char>(0x80 | (c & 0x3f));
+        }
+        used = p - buffer.get();
+    }
+}
+
+void OutputBuffer::writeJson(const wstring_view s)
+{
+    put('"');
+    size_t begin = 0;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (is_json_safe(s[i])) continue;
+        writeUtf8(s.substr(begin, i - begin));
+        write_json_escape(*this, s[i]);
+        begin = i + 1;
+    }
+    writeUtf8(s.substr(begin));
+    put('"');
+}
+
+void OutputBuffer::writeJson(const string_view s)
+{
+    put('"');
+    size_t begin = 0;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        const auto c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        write(s.substr(begin, i - begin));
+        write_json_escape(*this, c);
+        begin = i + 1;
+    }
+    write(s.substr(begin));
+    put('"');
+}
+
+void OutputBuffer::flush()
+{
+    if (used == 0) return;
+    const auto size = used;
+    used = 0;
+    if (target != nullptr)
+    {
+        target->append(buffer.get(), size);
+    }
+    else
+    {
+        write_fd(fd, buffer.get(), size);
+    }
+}
+
+Exporter::Exporter(OutputBuffer& out, const ExportFormat format, const ExportTable tables)
+    : out(out)
+      , format(format)
+      , tables(tables)
+{
+    if (format == ExportFormat::Csv && !has_single_bit(static_cast<uint8_t>(tables)))
+    {
+        throw invalid_argument("csv export needs exactly one table");
+    }
+}
+
+template <typename T, typename R>
+void Exporter::writeRecord(const char* type, const T& item, R raw)
+{
+    // 原始记录加上模型中可编辑的数值，修改过或已经保存的实体都输出当前的值；名字取自模型
+    ScenarioWriter::writeNumbers(item, raw);
+    if (format == ExportFormat::JsonLines)
+    {
+        JsonVisitor visitor(out);
+        visit_record(visitor, type, file, scenario, item, raw);
+    }
+    else
+    {
+        if (!header_written)
+        {
+            CsvHeaderVisitor header(out);
+            visit_record(header, type, file, scenario, item, raw);
+            header_written = true;
+        }
+        CsvVisitor visitor(out);
+        visit_record(visitor, type, file, scenario, item, raw);
+    }
+    ++records;
+}
+
+void Exporter::writeScenario(const Scenario& item, const Raw::Scenario& raw)
+{
+    if (has_table(tables, ExportTable::GameData))
+    {
+        writeRecord("game_data", item.getGameData(), raw.game_data);
+    }
+    if (has_table(tables, ExportTable::Forces))
+    {
+        for (const auto* force : item.getForces())
+        {
+            writeRecord("force", *force, raw.forces[force->getIndex()]);
+        }
+    }
+    if (has_table(tables, ExportTable::Cities))
+    {
+        for (const auto* city : item.getCities())
+        {
+            writeRecord("city", *city, raw.cities[city->getIndex()]);
+        }
+    }
+    if (has_table(tables, ExportTable::Legions))
+    {
+        for (const auto* legion : item.getLegions())
+        {
+            writeRecord("legion", *legion, raw.legions[legion->getIndex()]);
+        }
+    }
+    if (has_table(tables, ExportTable::Characters))
+    {
+        for (const auto* character : item.getCharacters())
+        {
+            writeRecord("character", *character, raw.characters[character->getIndex()]);
+        }
+    }
+}
+
+void Exporter::write(const Scenario& item, const Raw::Scenario& raw, const fs::path& file_path, const size_t index)
+{
+    const auto path = file_path.u8string();
+    file.assign(path.begin(), path.end());
+    scenario = index;
+    writeScenario(item, raw);
+}
+
+void Exporter::write(const ScenarioFile& item)
+{
+    const auto path = item.getPath().u8string();
+    file.assign(path.begin(), path.end());
+    const auto& scenarios = item.getScenarios();
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        scenario = i;
+        writeScenario(scenarios[i], item.getImage()->getScenario(i));
+    }
+}
+
+void Exporter::write(const DragonGameObject& game)
+{
+    for (const auto& item : game.get_scenario_files())
+    {
+        write(item);
+    }
+    for (const auto& item : game.get_saved_files())
+    {
+        write(item);
+    }
+    write(game.get_default_saved_file());
+}
+}
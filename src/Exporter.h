@@ -0,0 +1,108 @@
+#pragma once
+#include "DragonData.h"
+
+#include <memory>
+#include <string_view>
+
+namespace DragonData
+{
+// 带固定缓冲区的输出，写满后一次性写入文件描述符；也可以输出到内存中的字符串。
+// 写入过程中不分配内存，写入失败时抛出 std::runtime_error。
+class OutputBuffer
+{
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    explicit OutputBuffer(int fd);
+    explicit OutputBuffer(string& target);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void put(char c)
+    {
+        if (used == BUFFER_SIZE) flush();
+        buffer[used++] = c;
+    }
+
+    void write(string_view s);
+    void writeNumber(int64_t value);
+    // 把 UTF-32（Windows 上为 UTF-16）编码为 UTF-8 写出
+    void writeUtf8(wstring_view s);
+    // 带引号并转义的 JSON 字符串；string_view 版本的内容已经是 UTF-8
+    void writeJson(wstring_view s);
+    void writeJson(string_view s);
+
+    void flush();
+
+private:
+    unique_ptr<char[]> buffer;
+    size_t used = 0;
+    int fd = -1;
+    string* target = nullptr;
+};
+
+enum class ExportFormat
+{
+    JsonLines = 0, // 每行一个 JSON 对象，包含 "type" 字段
+    Csv = 1,       // 每行一条记录，第一行为表头；只能导出一种实体
+};
+
+// 可按位组合
+enum class ExportTable : uint8_t
+{
+    GameData = 1,
+    Forces = 2,
+    Cities = 4,
+    Legions = 8,
+    Characters = 16,
+    All = 31,
+};
+
+constexpr ExportTable operator|(ExportTable a, ExportTable b)
+{
+    return static_cast<ExportTable>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+}
+
+constexpr bool has_table(ExportTable tables, ExportTable table)
+{
+    return (static_cast<uint8_t>(tables) & static_cast<uint8_t>(table)) != 0;
+}
+
+// 把解码后的实体导出为 JSON Lines 或 CSV，包含每个实体的全部字段。
+// 每条记录都带有来源文件与场景序号；其余列按 RawLayout 的字段表生成，列名与 Query 相同，数组元素为 name[i]。
+// 名字输出解码后的文本，实体之间的关联输出为对方的槽位，不存在时为 null（CSV 中为空）。
+class Exporter
+{
+public:
+    // CSV 格式只能指定一种实体，否则抛出 std::invalid_argument
+    Exporter(OutputBuffer& out, ExportFormat format, ExportTable tables = ExportTable::All);
+
+    void write(const DragonGameObject& game);
+    void write(const ScenarioFile& file);
+    // raw 为构建 scenario 的原始场景
+    void write(const Scenario& scenario, const Raw::Scenario& raw, const fs::path& file_path, size_t index);
+
+    [[nodiscard]] size_t getRecordCount() const
+    {
+        return records;
+    }
+
+private:
+    void writeScenario(const Scenario& scenario, const Raw::Scenario& raw);
+
+    // raw 按值传入，写入模型的当前值后输出
+    template <typename T, typename R>
+    void writeRecord(const char* type, const T& item, R raw);
+
+    OutputBuffer& out;
+    ExportFormat format;
+    ExportTable tables;
+    bool header_written = false;
+    size_t records = 0;
+    // 当前记录的来源
+    string file;
+    size_t scenario = 0;
+};
+}
@@ -0,0 +1,184 @@
+#include "Exporter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(Exporter, EncodeUtf8)
+{
+    std::string result;
+    {
+        OutputBuffer out(result);
+        out.writeUtf8(L"aé龍\U0001f409");
+        out.put(',');
+        out.writeNumber(-1234567890123);
+    }
+    EXPECT_EQ(result, "a\xc3\xa9\xe9\xbe\x8d\xf0\x9f\x90\x89,-1234567890123");
+
+    // 超过缓冲区大小的输出
+    result.clear();
+    OutputBuffer out(result);
+    const std::string line(1000, 'x');
+    for (int i = 0; i < 200; ++i)
+    {
+        out.write(line);
+    }
+    out.flush();
+    EXPECT_EQ(result.size(), 200000);
+}
+
+TEST(Exporter, JsonLines)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file;
+    ASSERT_TRUE(file.loadFile(data_path / "SINARIO-01.DAT"));
+
+    std::string result;
+    size_t expected = 0;
+    {
+        OutputBuffer out(result);
+        Exporter exporter(out, ExportFormat::JsonLines);
+        exporter.write(file);
+        for (const auto& scenario : file.getScenarios())
+        {
+            expected += 1 + scenario.getForces().size() + scenario.getCities().size() +
+                scenario.getLegions().size() + scenario.getCharacters().size();
+        }
+        EXPECT_EQ(exporter.getRecordCount(), expected);
+    }
+
+    std::istringstream lines(result);
+    size_t count = 0;
+    for (std::string line; std::getline(lines, line); ++count)
+    {
+        ASSERT_TRUE(line.starts_with(R"({"type":")")) << line;
+        ASSERT_TRUE(line.ends_with("}")) << line;
+        ASSERT_NE(line.find(R"(,"scenario":)"), std::string::npos);
+    }
+    EXPECT_EQ(count, expected);
+
+    const auto& character = *file.getScenarios()[0].getCharacters()[0];
+    std::string name;
+    {
+        OutputBuffer out(name);
+        out.writeUtf8(character.getName());
+    }
+    EXPECT_NE(result.find(R"("type":"character","file":")"), std::string::npos);
+    EXPECT_NE(result.find(R"("name":")" + name + R"(")"), std::string::npos);
+    EXPECT_NE(result.find(R"("type":"city")"), std::string::npos);
+    EXPECT_NE(result.find(R"(,"max_productivity":)"), std::string::npos);
+    EXPECT_NE(result.find(R"(,"to_board":)"), std::string::npos);
+    // 数值列按字段表生成，数组元素为 name[i]
+    EXPECT_NE(result.find(R"(,"city_count":)"), std::string::npos);
+    EXPECT_NE(result.find(R"(,"cur_conscription[2]":)"), std::string::npos);
+    EXPECT_NE(result.find(R"(,"next_conscription[0]":)"), std::string::npos);
+    EXPECT_EQ(result.find(R"("reserved_)"), std::string::npos);
+
+    // status_string 在加载时生成，不会导出空字符串
+    EXPECT_FALSE(character.getStatusString().empty());
+    EXPECT_EQ(result.find(R"("status_string":"")"), std::string::npos);
+    std::string status;
+    {
+        OutputBuffer out(status);
+        out.writeUtf8(character.getStatusString());
+    }
+    EXPECT_NE(result.find(R"("status_string":")" + status + R"(")"), std::string::npos);
+}
+
+TEST(Exporter, CsvSingleTable)
+{
+    std::string result;
+    OutputBuffer out(result);
+    EXPECT_THROW(Exporter(out, ExportFormat::Csv), std::invalid_argument);
+    EXPECT_THROW(Exporter(out, ExportFormat::Csv, ExportTable::Cities | ExportTable::Forces), std::invalid_argument);
+
+    // 路径中的逗号需要加引号
+    auto data_path = fs::current_path() / "tests";
+    auto tmp_path = fs::temp_directory_path() / "Exporter,SAVE.DAT";
+    fs::copy_file(data_path / "SAVE.DAT", tmp_path, fs::copy_options::overwrite_existing);
+    ScenarioFile file;
+    ASSERT_TRUE(file.loadFile(tmp_path));
+
+    // 直接写入文件描述符
+    auto csv_path = fs::temp_directory_path() / "Exporter_cities.csv";
+    {
+        auto* fp = std::fopen(csv_path.string().c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        {
+            OutputBuffer fd_out(fileno(fp));
+            Exporter exporter(fd_out, ExportFormat::Csv, ExportTable::Cities);
+            exporter.write(file);
+            fd_out.flush();
+        }
+        std::fclose(fp);
+    }
+
+    std::ifstream csv(csv_path, std::ios::binary);
+    std::string header;
+    std::getline(csv, header);
+    EXPECT_EQ(header, "file,scenario,index,force,name,axis.x,axis.y,max_productivity,cur_productivity,increase,"
+                      "anti_disaster,soldiers,city_type,affairs_owner\r");
+    size_t rows = 0;
+    for (std::string line; std::getline(csv, line); ++rows)
+    {
+        ASSERT_TRUE(line.starts_with("\"" + tmp_path.string() + "\",")) << line;
+        EXPECT_EQ(std::count(line.begin(), line.end(), ','), 14);
+    }
+    size_t cities = 0;
+    for (const auto& scenario : file.getScenarios())
+    {
+        cities += scenario.getCities().size();
+    }
+    EXPECT_EQ(rows, cities);
+
+    csv.close();
+    fs::remove(csv_path);
+    fs::remove(tmp_path);
+}
+
+TEST(Exporter, ExportEditedValues)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(data_path / "SAVE.DAT"));
+    auto& character = *file.getScenarios().edit(1).getCharacters()[0];
+    character.setCommand(character.getCommand() == 99 ? 98 : 99);
+
+    std::string result;
+    {
+        OutputBuffer out(result);
+        Exporter exporter(out, ExportFormat::Csv, ExportTable::Characters);
+        exporter.write(file);
+    }
+    const auto split = [](const std::string& line)
+    {
+        std::vector<std::string> fields;
+        std::istringstream in(line);
+        for (std::string field; std::getline(in, field, ',');)
+        {
+            fields.push_back(field);
+        }
+        return fields;
+    };
+    std::istringstream lines(result);
+    std::string line;
+    std::getline(lines, line);
+    const auto header = split(line);
+    const auto column = static_cast<size_t>(std::find(header.begin(), header.end(), "command") - header.begin());
+    ASSERT_LT(column, header.size());
+
+    size_t found = 0;
+    while (std::getline(lines, line))
+    {
+        const auto fields = split(line);
+        if (fields[1] != "1" || fields[2] != std::to_string(character.getIndex())) continue;
+        EXPECT_EQ(fields[column], std::to_string(character.getCommand()));
+        ++found;
+    }
+    EXPECT_EQ(found, 1);
+}
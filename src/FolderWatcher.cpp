@@ -0,0 +1,263 @@
+#include "FolderWatcher.h"
+#include "BlockIndex.h"
+#include "RawFileImage.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <ranges>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+#ifdef __linux__
+    // 游戏原地改写存档时关闭文件产生 IN_CLOSE_WRITE，applySavedFile 通过改名替换产生 IN_MOVED_TO
+    constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+#endif
+
+    bool is_data_file(const fs::path& path)
+    {
+        const auto ext = path.extension().string();
+        return ext == ".dat" || ext == ".DAT";
+    }
+
+    uint64_t hash_image(const RawFileImage& image)
+    {
+        return hash_bytes(image.getData(), image.getFileSize());
+    }
+}
+
+FolderWatcher::FolderWatcher(DragonGameObject& game, const WatchOptions& options)
+    : game(game)
+      , options(options)
+      , saves_dir(game.get_game_folder_path() / "SAVES")
+      , default_save_path(game.get_game_folder_path() / "SAVE.DAT")
+{
+    if (game.get_game_folder_path().empty()) throw logic_error("game folder is not opened");
+    for (const auto& file : game.get_saved_files())
+    {
+        track(file, ScanFileKind::Saved);
+    }
+    if (game.get_default_saved_file().getImage()) track(game.get_default_saved_file(), ScanFileKind::DefaultSave);
+
+#ifdef __linux__
+    if (!options.use_inotify) return;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) return;
+    // 根目录中只关心 SAVE.DAT 以及 SAVES 目录本身的创建和移除
+    root_watch = inotify_add_watch(inotify_fd, game.get_game_folder_path().c_str(), WATCH_MASK | IN_CREATE);
+    if (root_watch < 0)
+    {
+        close(inotify_fd);
+        inotify_fd = -1;
+        return;
+    }
+    watchSavesDirectory();
+#endif
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef __linux__
+    if (inotify_fd >= 0) close(inotify_fd);
+#endif
+}
+
+void FolderWatcher::track(const SavedScenarioFile& file, const ScanFileKind kind)
+{
+    const auto& image = file.getImage();
+    watched[file.getPath()] = Watched{kind, file.getTimestamp(), image->getFileSize(), hash_image(*image), image};
+}
+
+ScanFileKind FolderWatcher::kindOf(const fs::path& path) const
+{
+    return path == default_save_path ? ScanFileKind::DefaultSave : ScanFileKind::Saved;
+}
+
+void FolderWatcher::listFiles(set<fs::path>& candidates) const
+{
+    error_code ec;
+    for (fs::directory_iterator it(saves_dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (it->is_regular_file(ec) && is_data_file(it->path())) candidates.insert(it->path());
+    }
+    if (fs::is_regular_file(default_save_path, ec)) candidates.insert(default_save_path);
+    for (const auto& path : watched | views::keys)
+    {
+        candidates.insert(path);
+    }
+}
+
+void FolderWatcher::watchSavesDirectory()
+{
+#ifdef __linux__
+    if (inotify_fd < 0 || saves_watch >= 0) return;
+    // SAVES 不存在时返回 -1，创建后由根目录的事件再次调用
+    saves_watch = inotify_add_watch(inotify_fd, saves_dir.c_str(), WATCH_MASK | IN_DELETE_SELF | IN_MOVE_SELF);
+#endif
+}
+
+bool FolderWatcher::readEvents(const chrono::milliseconds timeout, set<fs::path>& candidates)
+{
+#ifdef __linux__
+    pollfd descriptor{inotify_fd, POLLIN, 0};
+    const auto wait = static_cast<int>(min<chrono::milliseconds::rep>(timeout.count(), INT_MAX));
+    if (::poll(&descriptor, 1, wait) <= 0) return false;
+
+    bool rescan = false;
+    alignas(inotify_event) char buffer[4096];
+    for (ssize_t length; (length = read(inotify_fd, buffer, sizeof(buffer))) > 0;)
+    {
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // 队列溢出时丢失了事件，退回到完整扫描
+                rescan = true;
+            }
+            else if (event->wd == saves_watch && saves_watch >= 0)
+            {
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                {
+                    inotify_rm_watch(inotify_fd, saves_watch);
+                    saves_watch = -1;
+                    rescan = true;
+                }
+                else if (event->len != 0 && is_data_file(event->name))
+                {
+                    candidates.insert(saves_dir / event->name);
+                }
+            }
+            else if (event->wd == root_watch && event->len != 0)
+            {
+                if (string_view(event->name) == "SAVE.DAT")
+                {
+                    candidates.insert(default_save_path);
+                }
+                else if (string_view(event->name) == "SAVES" && (event->mask & IN_ISDIR))
+                {
+                    watchSavesDirectory();
+                    rescan = true;
+                }
+            }
+        }
+    }
+    if (rescan) listFiles(candidates);
+    return true;
+#else
+    (void)timeout;
+    (void)candidates;
+    return false;
+#endif
+}
+
+optional<FolderChange> FolderWatcher::refresh(const fs::path& path)
+{
+    const auto kind = kindOf(path);
+    const auto it = watched.find(path);
+    error_code ec;
+    if (!fs::is_regular_file(path, ec))
+    {
+        if (it == watched.end()) return nullopt;
+        const bool loaded = it->second.snapshot != nullptr;
+        watched.erase(it);
+        if (!loaded) return nullopt;
+        game.removeSavedFile(path);
+        return FolderChange{FolderEvent::Removed, kind, path, {}};
+    }
+
+    const auto timestamp = fs::last_write_time(path, ec);
+    const auto size = ec ? 0 : fs::file_size(path, ec);
+    if (ec) return nullopt;
+    // 修改时间与大小都未变化时不读取内容
+    if (it != watched.end() && it->second.timestamp == timestamp && it->second.size == size) return nullopt;
+
+    RawFileImagePtr image;
+    try
+    {
+        image = RawFileImage::open(path, ImageMode::Copy);
+    }
+    catch (const runtime_error& e)
+    {
+        cerr << "Failed to open saved file: " << e.what() << endl;
+    }
+    // 内容未变化（例如只更新了修改时间）时不重新解析
+    if (image && it != watched.end() && it->second.snapshot && it->second.hash == hash_image(*image))
+    {
+        it->second.timestamp = timestamp;
+        it->second.size = size;
+        return nullopt;
+    }
+
+    SavedScenarioFile file(game.get_load_mode(), game.get_scenario_pool());
+    bool loaded = false;
+    if (image)
+    {
+        try
+        {
+            loaded = file.loadFile(path);
+        }
+        catch (const exception& e)
+        {
+            cerr << "Failed to load saved file: " << e.what() << endl;
+        }
+    }
+    if (!loaded)
+    {
+        // 写到一半或内容无效：保留旧内容，记下时间和大小，文件再次改写后重试
+        auto& entry = watched[path];
+        entry.kind = kind;
+        entry.timestamp = timestamp;
+        entry.size = size;
+        return nullopt;
+    }
+
+    FolderChange change{FolderEvent::Added, kind, path, {}};
+    if (it != watched.end() && it->second.snapshot)
+    {
+        change.event = FolderEvent::Modified;
+        diff_files(it->second.snapshot->getFile(), file.getImage()->getFile(), change.fields, options.diff);
+    }
+    track(file, kind);
+    game.putSavedFile(std::move(file), kind);
+    return change;
+}
+
+vector<FolderChange> FolderWatcher::poll(const chrono::milliseconds timeout)
+{
+    const auto deadline = chrono::steady_clock::now() + timeout;
+    const auto remaining = [&deadline]
+    {
+        return max(chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()),
+                   chrono::milliseconds::zero());
+    };
+
+    vector<FolderChange> changes;
+    for (;;)
+    {
+        set<fs::path> candidates;
+        if (usesInotify()) readEvents(remaining(), candidates);
+        else listFiles(candidates);
+
+        for (const auto& path : candidates)
+        {
+            if (auto change = refresh(path)) changes.push_back(std::move(*change));
+        }
+        // 事件或扫描没有带来内容变化时继续等待
+        if (!changes.empty() || remaining() == chrono::milliseconds::zero()) return changes;
+        if (!usesInotify()) this_thread::sleep_for(min(remaining(), options.poll_interval));
+    }
+}
+}
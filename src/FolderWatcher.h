@@ -0,0 +1,92 @@
+#pragma once
+#include "DragonData.h"
+#include "ScenarioDiff.h"
+
+#include <chrono>
+#include <map>
+#include <set>
+
+namespace DragonData
+{
+enum class FolderEvent : uint8_t
+{
+    Added = 0,
+    Modified = 1,
+    Removed = 2,
+};
+
+struct FolderChange
+{
+    FolderEvent event;
+    ScanFileKind kind;
+    fs::path path;
+    // Modified 时新旧内容之间的字段变化，Added 和 Removed 时为空
+    vector<FieldChange> fields;
+};
+
+struct WatchOptions
+{
+    // 为 false 或平台不支持时按修改时间和大小轮询
+    bool use_inotify = true;
+    // 轮询模式下 poll 等待期间两次扫描的间隔
+    chrono::milliseconds poll_interval{500};
+    DiffOptions diff;
+};
+
+// 监视游戏运行时会改写的 SAVES/*.DAT 与 SAVE.DAT，只重新解析内容确实变化的文件并更新 DragonGameObject。
+// SINARIO 中的场景文件不会被游戏改写，不监视。
+// 存档以 ImageMode::Copy 读入私有副本，游戏原地改写或截断文件时旧映像保持不变，直接作为比较用的快照。
+// 不是线程安全的：poll 与对 game 的访问须在同一线程；game 重新打开文件夹后需要重新创建。
+class FolderWatcher
+{
+public:
+    explicit FolderWatcher(DragonGameObject& game, const WatchOptions& options = {});
+    ~FolderWatcher();
+
+    FolderWatcher(const FolderWatcher&) = delete;
+    FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+    // 等待至多 timeout 直到有文件变化，处理期间到达的全部变化后返回，按路径排序。
+    // 写到一半的文件无法通过校验，保留旧内容，写完后再次报告
+    vector<FolderChange> poll(chrono::milliseconds timeout = chrono::milliseconds::zero());
+
+    [[nodiscard]] bool usesInotify() const
+    {
+        return inotify_fd >= 0;
+    }
+
+    // 当前监视的文件数
+    [[nodiscard]] size_t size() const
+    {
+        return watched.size();
+    }
+
+private:
+    struct Watched
+    {
+        ScanFileKind kind = ScanFileKind::Saved;
+        fs::file_time_type timestamp;
+        uintmax_t size = 0;
+        uint64_t hash = 0;
+        // 上次解析时的文件映像，校验失败的文件为空
+        RawFileImagePtr snapshot;
+    };
+
+    void track(const SavedScenarioFile& file, ScanFileKind kind);
+    [[nodiscard]] ScanFileKind kindOf(const fs::path& path) const;
+    // 文件夹中当前的存档与 SAVE.DAT，以及已监视的文件（可能已被删除）
+    void listFiles(set<fs::path>& candidates) const;
+    bool readEvents(chrono::milliseconds timeout, set<fs::path>& candidates);
+    void watchSavesDirectory();
+    optional<FolderChange> refresh(const fs::path& path);
+
+    DragonGameObject& game;
+    WatchOptions options;
+    fs::path saves_dir;
+    fs::path default_save_path;
+    map<fs::path, Watched> watched;
+    int inotify_fd = -1;
+    int root_watch = -1;
+    int saves_watch = -1;
+};
+}
@@ -0,0 +1,170 @@
+#include "FolderWatcher.h"
+#include "BlockIndex.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace
+{
+// 原地改写一个字节并推后修改时间，模拟游戏在同一秒内多次存档
+void write_byte(const fs::path& path, const size_t offset, const uint8_t value)
+{
+    const auto timestamp = fs::last_write_time(path);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(value));
+    }
+    fs::last_write_time(path, timestamp + 1s);
+}
+}
+
+TEST(FolderWatcher, IncrementalReload)
+{
+    auto data_path = fs::current_path() / "tests";
+    for (const bool use_inotify : {true, false})
+    {
+        auto game_path = fs::temp_directory_path() / "FolderWatcher_game";
+        fs::remove_all(game_path);
+        fs::create_directories(game_path / "SINARIO");
+        fs::create_directories(game_path / "SAVES");
+        fs::copy_file(data_path / "SINARIO-01.DAT", game_path / "SINARIO" / "SINARIO-01.DAT");
+        fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVES" / "SAVE1.DAT");
+        fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVES" / "SAVE2.DAT");
+        fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVE.DAT");
+
+        DragonGameObject game;
+        auto folder = game_path.string();
+        ScanOptions scan;
+        scan.mode = LoadMode::Lazy;
+        ASSERT_TRUE(game.openGameFolder(folder, scan));
+
+        WatchOptions options;
+        options.use_inotify = use_inotify;
+        options.poll_interval = 10ms;
+        FolderWatcher watcher(game, options);
+        EXPECT_EQ(watcher.size(), 3);
+#ifdef __linux__
+        EXPECT_EQ(watcher.usesInotify(), use_inotify);
+#endif
+        EXPECT_TRUE(watcher.poll().empty());
+
+        // 改写存档中一个人物的统率，只报告这一个字段
+        const auto& raw = game.get_saved_files()[0].getImage()->getScenario(0);
+        const auto slot = static_cast<size_t>(std::find_if(std::begin(raw.characters), std::end(raw.characters),
+                                                           [](const Raw::Character& c) { return c.name.name[0] != 0; })
+            - std::begin(raw.characters));
+        ASSERT_LT(slot, MAX_CHARACTERS);
+        const uint8_t command = raw.characters[slot].command;
+        const auto offset = offsetof(Raw::Scenario, characters) + slot * sizeof(Raw::Character)
+            + offsetof(Raw::Character, command);
+        const auto save_path = game_path / "SAVES" / "SAVE1.DAT";
+        write_byte(save_path, offset, command + 1);
+
+        auto changes = watcher.poll(2s);
+        ASSERT_EQ(changes.size(), 1);
+        EXPECT_EQ(changes[0].event, FolderEvent::Modified);
+        EXPECT_EQ(changes[0].kind, ScanFileKind::Saved);
+        EXPECT_EQ(changes[0].path, save_path);
+        ASSERT_EQ(changes[0].fields.size(), 1);
+        EXPECT_EQ(changes[0].fields[0].table, BlockKind::Characters);
+        EXPECT_EQ(changes[0].fields[0].record, slot);
+        EXPECT_EQ(changes[0].fields[0].field->name, std::string_view("command"));
+        EXPECT_EQ(changes[0].fields[0].before, command);
+        EXPECT_EQ(changes[0].fields[0].after, command + 1);
+        EXPECT_EQ(game.get_saved_files()[0].getScenarios()[0].getCharacters().front()->getCommand(), command + 1);
+        EXPECT_EQ(game.get_block_index()->blockCount(BlockKind::Scenario), 4 * 4);
+
+        // 只更新修改时间不会重新解析
+        fs::last_write_time(save_path, fs::last_write_time(save_path) + 1s);
+        EXPECT_TRUE(watcher.poll(50ms).empty());
+
+        // 写到一半的文件不报告，删除后也不报告
+        const auto partial_path = game_path / "SAVES" / "SAVE3.DAT";
+        std::ofstream(partial_path, std::ios::binary) << "partial";
+        EXPECT_TRUE(watcher.poll(50ms).empty());
+        fs::remove(partial_path);
+        EXPECT_TRUE(watcher.poll(50ms).empty());
+
+        fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVES" / "SAVE0.DAT");
+        changes = watcher.poll(2s);
+        ASSERT_EQ(changes.size(), 1);
+        EXPECT_EQ(changes[0].event, FolderEvent::Added);
+        ASSERT_EQ(game.get_saved_files().size(), 3);
+        EXPECT_EQ(game.get_saved_files()[0].getPath().filename(), "SAVE0.DAT");
+
+        fs::remove(game_path / "SAVES" / "SAVE2.DAT");
+        changes = watcher.poll(2s);
+        ASSERT_EQ(changes.size(), 1);
+        EXPECT_EQ(changes[0].event, FolderEvent::Removed);
+        EXPECT_EQ(game.get_saved_files().size(), 2);
+
+        write_byte(game_path / "SAVE.DAT", offset, command + 2);
+        changes = watcher.poll(2s);
+        ASSERT_EQ(changes.size(), 1);
+        EXPECT_EQ(changes[0].kind, ScanFileKind::DefaultSave);
+        EXPECT_EQ(changes[0].fields.size(), 1);
+        EXPECT_EQ(game.get_block_index()->blockCount(BlockKind::Scenario), 4 * 4);
+        EXPECT_EQ(watcher.size(), 3);
+
+        fs::remove_all(game_path);
+    }
+}
+
+TEST(FolderWatcher, TruncateAndRewrite)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto game_path = fs::temp_directory_path() / "FolderWatcher_truncate";
+    fs::remove_all(game_path);
+    fs::create_directories(game_path / "SINARIO");
+    fs::create_directories(game_path / "SAVES");
+    fs::copy_file(data_path / "SINARIO-01.DAT", game_path / "SINARIO" / "SINARIO-01.DAT");
+    const auto save_path = game_path / "SAVES" / "SAVE1.DAT";
+    fs::copy_file(data_path / "SAVE.DAT", save_path);
+
+    DragonGameObject game;
+    auto folder = game_path.string();
+    ScanOptions scan;
+    scan.mode = LoadMode::Lazy;
+    ASSERT_TRUE(game.openGameFolder(folder, scan));
+    WatchOptions options;
+    options.poll_interval = 10ms;
+    FolderWatcher watcher(game, options);
+
+    // 存档读入私有副本，不是映射
+    const auto& file = game.get_saved_files()[0];
+    ASSERT_FALSE(file.getImage()->isMapped());
+    std::vector<uint8_t> content(file.getImage()->getData(), file.getImage()->getData() + fs::file_size(save_path));
+
+    // 游戏原地截断存档：已加载的映像不受影响，尚未构建的场景仍可构建
+    std::ofstream(save_path, std::ios::binary | std::ios::trunc).close();
+    ASSERT_EQ(fs::file_size(save_path), 0);
+    EXPECT_FALSE(file.getScenarios().isMaterialized(3));
+    EXPECT_EQ(file.getScenarios()[3].getCharacters().size(),
+              ScenarioList(RawFileImage::open(data_path / "SAVE.DAT"))[3].getCharacters().size());
+    EXPECT_TRUE(watcher.poll(50ms).empty());
+    EXPECT_EQ(game.get_saved_files().size(), 1);
+
+    // 写完后报告与截断前相比的变化
+    const auto offset = offsetof(Raw::Scenario, game_data) + offsetof(Raw::GameData, year);
+    ++content[offset];
+    {
+        std::ofstream out(save_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+    }
+    fs::last_write_time(save_path, fs::last_write_time(save_path) + 1s);
+    const auto changes = watcher.poll(2s);
+    ASSERT_EQ(changes.size(), 1);
+    EXPECT_EQ(changes[0].event, FolderEvent::Modified);
+    ASSERT_EQ(changes[0].fields.size(), 1);
+    EXPECT_EQ(changes[0].fields[0].table, BlockKind::GameData);
+    EXPECT_FALSE(game.get_saved_files()[0].getImage()->isMapped());
+
+    fs::remove_all(game_path);
+}
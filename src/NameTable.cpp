@@ -0,0 +1,168 @@
+#include "NameTable.h"
+#include "DragonData.h"
+
+#include <algorithm>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <boost/locale.hpp>
+
+using namespace std;
+namespace conv = boost::locale::conv;
+
+namespace DragonData
+{
+const Big5Table& Big5Table::instance()
+{
+    static const Big5Table table;
+    return table;
+}
+
+Big5Table::Big5Table()
+{
+    // 每行由 "码\n" 组成，无效码会被跳过，借助分隔符即可对齐每个码的转换结果
+    for (unsigned lead = LEAD_MIN; lead <= LEAD_MAX; ++lead)
+    {
+        string row;
+        row.reserve(TRAIL_COUNT * 3);
+        for (unsigned trail = 0x40; trail <= 0xfe; ++trail)
+        {
+            if (trail > 0x7e && trail < 0xa1) continue;
+            row += static_cast<char>(lead);
+            row += static_cast<char>(trail);
+            row += '\n';
+        }
+
+        wstring out;
+        try
+        {
+            out = conv::to_utf<wchar_t>(row, "BIG5", conv::skip);
+        }
+        catch (...)
+        {
+            continue;
+        }
+
+        size_t column = 0;
+        size_t begin = 0;
+        for (size_t i = 0; i < out.size() && column < TRAIL_COUNT; ++i)
+        {
+            if (out[i] != L'\n') continue;
+            if (i - begin == 1 && static_cast<uint32_t>(out[begin]) >= 0x80)
+            {
+                table[(lead - LEAD_MIN) * TRAIL_COUNT + column] = out[begin];
+                const auto trail = column < 0x3f ? 0x40 + column : 0xa1 + column - 0x3f;
+                reverse.try_emplace(out[begin], static_cast<uint16_t>(lead << 8 | trail));
+            }
+            ++column;
+            begin = i + 1;
+        }
+    }
+}
+
+bool Big5Table::decode(const char* s, const size_t len, wstring& out) const
+{
+    out.clear();
+    out.reserve(len);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(s);
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (bytes[i] < 0x80)
+        {
+            out += static_cast<wchar_t>(bytes[i]);
+            continue;
+        }
+        if (i + 1 >= len) return false;
+        const wchar_t ch = lookup(bytes[i], bytes[i + 1]);
+        if (ch == 0) return false;
+        out += ch;
+        ++i;
+    }
+    return true;
+}
+
+void Big5Table::encode(const wstring& value, char* out, const size_t len) const
+{
+    size_t n = 0;
+    for (const wchar_t ch : value)
+    {
+        if (static_cast<uint32_t>(ch) < 0x80)
+        {
+            if (n + 1 > len) throw invalid_argument("name too long for BIG5 field");
+            out[n++] = static_cast<char>(ch);
+            continue;
+        }
+
+        const auto it = reverse.find(ch);
+        if (it == reverse.end()) throw invalid_argument("name not representable in BIG5");
+        if (n + 2 > len) throw invalid_argument("name too long for BIG5 field");
+        out[n++] = static_cast<char>(it->second >> 8);
+        out[n++] = static_cast<char>(it->second & 0xff);
+    }
+    fill(out + n, out + len, '\0');
+}
+
+namespace
+{
+    class NameTable
+    {
+    public:
+        const wstring& intern(const char* s, const size_t len)
+        {
+            const string_view key(s, len);
+            {
+                shared_lock lock(mutex);
+                if (const auto it = names.find(key); it != names.end()) return it->second;
+            }
+
+            wstring decoded = name_to_utf8(s, len);
+            unique_lock lock(mutex);
+            return names.try_emplace(string(key), std::move(decoded)).first->second;
+        }
+
+        size_t size()
+        {
+            shared_lock lock(mutex);
+            return names.size();
+        }
+
+    private:
+        struct Hash
+        {
+            using is_transparent = void;
+
+            size_t operator()(const string_view key) const
+            {
+                return hash<string_view>{}(key);
+            }
+        };
+
+        shared_mutex mutex;
+        // 节点式容器，元素地址在插入后保持不变
+        unordered_map<string, wstring, Hash, equal_to<>> names;
+    };
+
+    NameTable& name_table()
+    {
+        static NameTable table;
+        return table;
+    }
+}
+
+const wstring& intern_name(const char* s, const size_t len)
+{
+    return name_table().intern(s, len);
+}
+
+const wstring& intern_encoded_name(const wstring& value, const size_t len)
+{
+    string encoded(len, '\0');
+    Big5Table::instance().encode(value, encoded.data(), len);
+    return intern_name(encoded.data(), len);
+}
+
+size_t interned_name_count()
+{
+    return name_table().size();
+}
+}
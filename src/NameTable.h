@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+namespace DragonData
+{
+// BIG5 双字节码查找表。首次使用时借助 boost::locale 按首字节逐行生成，
+// 与 name_to_utf8 原有的转换结果完全一致。
+class Big5Table
+{
+public:
+    static constexpr uint8_t LEAD_MIN = 0x81;
+    static constexpr uint8_t LEAD_MAX = 0xfe;
+    static constexpr size_t TRAIL_COUNT = 157; // 0x40-0x7e, 0xa1-0xfe
+
+    static const Big5Table& instance();
+
+    // 所有字节都能查表解码时返回 true 并写入 out；否则需要回退到 boost::locale
+    bool decode(const char* s, size_t len, wstring& out) const;
+
+    // 编码为 BIG5 写入 out，剩余字节补零；无法编码或超出 len 字节时抛出 std::invalid_argument
+    void encode(const wstring& value, char* out, size_t len) const;
+
+    // 查表得到单个双字节码对应的字符，无映射时返回 0
+    [[nodiscard]] wchar_t lookup(uint8_t lead, uint8_t trail) const
+    {
+        const auto index = indexOf(lead, trail);
+        return index < table.size() ? table[index] : 0;
+    }
+
+private:
+    Big5Table();
+
+    static size_t indexOf(uint8_t lead, uint8_t trail)
+    {
+        if (lead < LEAD_MIN || lead > LEAD_MAX) return SIZE_MAX;
+        size_t column;
+        if (trail >= 0x40 && trail <= 0x7e) column = trail - 0x40;
+        else if (trail >= 0xa1 && trail <= 0xfe) column = trail - 0xa1 + 0x3f;
+        else return SIZE_MAX;
+        return (lead - LEAD_MIN) * TRAIL_COUNT + column;
+    }
+
+    array<wchar_t, (LEAD_MAX - LEAD_MIN + 1) * TRAIL_COUNT> table{};
+    unordered_map<wchar_t, uint16_t> reverse;
+};
+
+// 按原始 BIG5 字节驻留解码结果。返回的引用在进程生命周期内保持有效，
+// 同一名字在所有文件、所有场景之间只解码一次。线程安全。
+const wstring& intern_name(const char* s, size_t len);
+
+// 把名字编码为 len 字节的 BIG5 后驻留，异常同 Big5Table::encode
+const wstring& intern_encoded_name(const wstring& value, size_t len);
+
+size_t interned_name_count();
+}
@@ -0,0 +1,46 @@
+#include "NameTable.h"
+#include "DragonData.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <boost/locale.hpp>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(NameTable, TableMatchesBoostLocale)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+
+    for (const auto& character : image->getScenario(0).characters)
+    {
+        std::string in(character.name.name, std::size(character.name.name));
+        while (!in.empty() && in.back() == '\0') in.pop_back();
+
+        std::wstring decoded;
+        ASSERT_TRUE(Big5Table::instance().decode(in.data(), in.size(), decoded));
+        EXPECT_EQ(decoded, boost::locale::conv::to_utf<wchar_t>(in, "BIG5"));
+    }
+}
+
+TEST(NameTable, InternReturnsStableReference)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto first = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    auto second = RawFileImage::open(data_path / "SINARIO-02.DAT");
+    ASSERT_TRUE(first && second);
+
+    const auto& name = first->getScenario(0).characters[0].name.name;
+    const auto& a = intern_name(name, std::size(name));
+    const auto count = interned_name_count();
+
+    std::array<char, sizeof(Raw::Name::name)> copy{};
+    std::copy(std::begin(name), std::end(name), copy.begin());
+    const auto& b = intern_name(copy.data(), copy.size());
+    EXPECT_EQ(&a, &b);
+    EXPECT_EQ(interned_name_count(), count);
+    EXPECT_EQ(a, name_to_utf8(name, std::size(name)));
+    EXPECT_FALSE(a.empty());
+}
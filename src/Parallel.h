@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace DragonData
+{
+// 以 threads 个线程（0 表示硬件并发数，且不超过 count）对 [0, count) 的每个下标调用一次 f(i)，
+// 下标按原子计数器依次领取，调用线程也参与处理，全部完成后返回。
+// f 应把结果写到按下标划分的位置，各线程之间不共享可写数据，结果因此与线程数无关。
+template <typename F>
+void parallel_for(const size_t count, const size_t threads, F&& f)
+{
+    atomic<size_t> next{0};
+    auto worker = [&]
+    {
+        for (size_t i; (i = next++) < count;)
+        {
+            f(i);
+        }
+    };
+
+    size_t thread_count = threads != 0 ? threads : max(1u, thread::hardware_concurrency());
+    thread_count = min(thread_count, count);
+    vector<jthread> workers;
+    for (size_t i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
+}
@@ -0,0 +1,27 @@
+#include "Parallel.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace DragonData;
+
+
+TEST(Parallel, VisitEachIndexOnce)
+{
+    for (const size_t threads : {0, 1, 3, 64})
+    {
+        std::vector<std::atomic<int>> visits(1000);
+        parallel_for(visits.size(), threads, [&](const size_t i) { ++visits[i]; });
+        EXPECT_TRUE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& n) { return n == 1; }))
+            << threads;
+    }
+
+    // 没有下标时不调用 f，也不启动线程
+    size_t calls = 0;
+    parallel_for(0, 4, [&](size_t) { ++calls; });
+    EXPECT_EQ(calls, 0);
+
+    // 只有一个线程时在调用线程上按顺序处理
+    std::vector<size_t> order;
+    parallel_for(5, 1, [&](const size_t i) { order.push_back(i); });
+    EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4}));
+}
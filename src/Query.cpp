@@ -0,0 +1,317 @@
+#include "Query.h"
+#include "Parallel.h"
+#include "ScenarioDiff.h"
+
+#include <charconv>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    bool compare(const int64_t x, const CompareOp op, const int64_t value)
+    {
+        switch (op)
+        {
+        case CompareOp::Equal:
+            return x == value;
+        case CompareOp::NotEqual:
+            return x != value;
+        case CompareOp::Less:
+            return x < value;
+        case CompareOp::LessEqual:
+            return x <= value;
+        case CompareOp::Greater:
+            return x > value;
+        case CompareOp::GreaterEqual:
+            return x >= value;
+        }
+        return false;
+    }
+
+    void merge(QueryAggregate& result, const QueryAggregate& other)
+    {
+        if (other.count == 0) return;
+        result.min = result.count == 0 ? other.min : min(result.min, other.min);
+        result.max = result.count == 0 ? other.max : max(result.max, other.max);
+        result.count += other.count;
+        result.sum += other.sum;
+    }
+
+    // 查询的文件：场景文件、存档、SAVE.DAT（存在时）
+    vector<const ScenarioFile*> query_files(const DragonGameObject& game)
+    {
+        vector<const ScenarioFile*> files;
+        for (const auto& file : game.get_scenario_files())
+        {
+            files.push_back(&file);
+        }
+        for (const auto& file : game.get_saved_files())
+        {
+            files.push_back(&file);
+        }
+        if (game.get_default_saved_file().getImage())
+        {
+            files.push_back(&game.get_default_saved_file());
+        }
+        return files;
+    }
+
+    // 每个文件的结果写入 results 中对应的位置，各线程之间不共享可写数据
+    template <typename T, typename F>
+    vector<T> for_each_file(const vector<const ScenarioFile*>& files, const QueryOptions& options, F&& f)
+    {
+        vector<T> results(files.size());
+        parallel_for(files.size(), options.threads, [&](const size_t i) { results[i] = f(*files[i]); });
+        return results;
+    }
+}
+
+BlockKind parse_table(const string_view name)
+{
+    if (name == "game_data") return BlockKind::GameData;
+    if (name == "forces") return BlockKind::Forces;
+    if (name == "cities") return BlockKind::Cities;
+    if (name == "legions") return BlockKind::Legions;
+    if (name == "characters") return BlockKind::Characters;
+    throw invalid_argument("unknown table: " + string(name));
+}
+
+string_view table_key(const BlockKind table)
+{
+    switch (table)
+    {
+    case BlockKind::GameData:
+        return "game_data";
+    case BlockKind::Forces:
+        return "forces";
+    case BlockKind::Friendship:
+        return "friendship";
+    case BlockKind::Cities:
+        return "cities";
+    case BlockKind::Legions:
+        return "legions";
+    case BlockKind::Characters:
+        return "characters";
+    default:
+        return "scenario";
+    }
+}
+
+CompareOp parse_compare_op(const string_view text)
+{
+    if (text == "==") return CompareOp::Equal;
+    if (text == "!=") return CompareOp::NotEqual;
+    if (text == "<") return CompareOp::Less;
+    if (text == "<=") return CompareOp::LessEqual;
+    if (text == ">") return CompareOp::Greater;
+    if (text == ">=") return CompareOp::GreaterEqual;
+    throw invalid_argument("unknown operator: " + string(text));
+}
+
+FieldRef find_field(const BlockKind table, const string_view field)
+{
+    // name[i] 表示数组的第 i 个元素
+    auto name = field;
+    size_t element = 0;
+    if (const auto open = field.find('['); open != string_view::npos && field.back() == ']')
+    {
+        name = field.substr(0, open);
+        const auto digits = field.substr(open + 1, field.size() - open - 2);
+        const auto [end, ec] = from_chars(digits.data(), digits.data() + digits.size(), element);
+        if (ec != errc() || end != digits.data() + digits.size() || digits.empty())
+        {
+            throw invalid_argument("invalid field: " + string(field));
+        }
+    }
+
+    for (const auto& info : record_fields(table))
+    {
+        if (name != info.name) continue;
+        if (info.isReserved() || element >= info.count) break;
+        return {&info, static_cast<uint16_t>(info.offset + element * info.stride)};
+    }
+    throw invalid_argument("unknown field: " + string(field));
+}
+
+Query::Query(const BlockKind table)
+    : table(table)
+{
+    if (table == BlockKind::Scenario || table == BlockKind::Friendship)
+    {
+        throw invalid_argument("table can not be queried");
+    }
+}
+
+Query::Column Query::column(const string_view field) const
+{
+    return find_field(table, field);
+}
+
+Query::Column Query::numericColumn(const string_view field) const
+{
+    const auto c = column(field);
+    if (c.field->type == FieldType::Name) throw invalid_argument("field is not numeric: " + string(field));
+    return c;
+}
+
+Query& Query::where(const string_view field, const CompareOp op, const int64_t value)
+{
+    const auto c = numericColumn(field);
+    conditions.push_back({c.offset, c.field->type, op, value});
+    return *this;
+}
+
+Query& Query::select(const string_view field)
+{
+    columns.push_back(column(field));
+    return *this;
+}
+
+bool Query::matches(const uint8_t* record) const
+{
+    if (!is_record_occupied(table, record)) return false;
+    for (const auto& condition : conditions)
+    {
+        if (!compare(read_field(record + condition.offset, condition.type), condition.op, condition.value))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Query::run(const Raw::Scenario& raw, vector<QueryRow>& out, const uint8_t scenario,
+                  const ScenarioFile* file) const
+{
+    const auto block = block_span(raw, table);
+    const auto size = record_size(table);
+    size_t count = 0;
+    for (size_t slot = 0; slot < record_count(table); ++slot)
+    {
+        const auto* record = block.data + slot * size;
+        if (!matches(record)) continue;
+
+        QueryRow row{file, scenario, static_cast<uint8_t>(slot), {}};
+        row.values.reserve(columns.size());
+        for (const auto& c : columns)
+        {
+            if (c.field->type == FieldType::Name)
+            {
+                const auto* name = reinterpret_cast<const char*>(record + c.offset);
+                row.values.emplace_back(intern_name(name, c.field->size));
+            }
+            else
+            {
+                row.values.emplace_back(read_field(record + c.offset, c.field->type));
+            }
+        }
+        out.push_back(std::move(row));
+        ++count;
+    }
+    return count;
+}
+
+vector<QueryRow> Query::run(const ScenarioFile& file) const
+{
+    vector<QueryRow> rows;
+    const auto& image = file.getImage();
+    if (!image) return rows;
+    for (uint8_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        run(image->getScenario(i), rows, i, &file);
+    }
+    return rows;
+}
+
+vector<QueryRow> Query::run(const DragonGameObject& game, const QueryOptions& options) const
+{
+    auto results = for_each_file<vector<QueryRow>>(query_files(game), options, [this](const ScenarioFile& file)
+    {
+        return run(file);
+    });
+
+    vector<QueryRow> rows;
+    for (auto& result : results)
+    {
+        rows.insert(rows.end(), make_move_iterator(result.begin()), make_move_iterator(result.end()));
+    }
+    return rows;
+}
+
+void Query::accumulate(const Raw::Scenario& raw, const Column& column, QueryAggregate& result) const
+{
+    const auto block = block_span(raw, table);
+    const auto size = record_size(table);
+    for (size_t slot = 0; slot < record_count(table); ++slot)
+    {
+        const auto* record = block.data + slot * size;
+        if (!matches(record)) continue;
+        const auto value = column.field ? read_field(record + column.offset, column.field->type) : 0;
+        merge(result, {1, value, value, value});
+    }
+}
+
+void Query::accumulate(const ScenarioFile& file, const Column& column, QueryAggregate& result) const
+{
+    const auto& image = file.getImage();
+    if (!image) return;
+    for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        accumulate(image->getScenario(i), column, result);
+    }
+}
+
+QueryAggregate Query::aggregate(const string_view field, const Raw::Scenario& raw) const
+{
+    QueryAggregate result;
+    accumulate(raw, numericColumn(field), result);
+    return result;
+}
+
+QueryAggregate Query::aggregate(const string_view field, const ScenarioFile& file) const
+{
+    QueryAggregate result;
+    accumulate(file, numericColumn(field), result);
+    return result;
+}
+
+QueryAggregate Query::aggregate(const string_view field, const DragonGameObject& game,
+                                const QueryOptions& options) const
+{
+    const auto c = numericColumn(field);
+    const auto results = for_each_file<QueryAggregate>(query_files(game), options, [this, c](const ScenarioFile& file)
+    {
+        QueryAggregate result;
+        accumulate(file, c, result);
+        return result;
+    });
+
+    QueryAggregate result;
+    for (const auto& other : results)
+    {
+        merge(result, other);
+    }
+    return result;
+}
+
+size_t Query::count(const DragonGameObject& game, const QueryOptions& options) const
+{
+    // 不取字段，只统计匹配的记录
+    const auto results = for_each_file<QueryAggregate>(query_files(game), options, [this](const ScenarioFile& file)
+    {
+        QueryAggregate result;
+        accumulate(file, {nullptr, 0}, result);
+        return result;
+    });
+
+    size_t count = 0;
+    for (const auto& result : results)
+    {
+        count += result.count;
+    }
+    return count;
+}
+}
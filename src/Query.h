@@ -0,0 +1,134 @@
+#pragma once
+#include "RawLayout.h"
+
+#include <string_view>
+#include <variant>
+
+namespace DragonData
+{
+enum class CompareOp : uint8_t
+{
+    Equal = 0,
+    NotEqual = 1,
+    Less = 2,
+    LessEqual = 3,
+    Greater = 4,
+    GreaterEqual = 5,
+};
+
+// 数值字段为 int64_t，名字字段为解码后的文字
+using QueryValue = variant<int64_t, wstring>;
+
+struct QueryRow
+{
+    const ScenarioFile* file; // 直接查询 Raw::Scenario 时为 nullptr
+    uint8_t scenario;
+    uint8_t slot; // 原始槽位，可用 Scenario::findCharacter 等取得对象
+    vector<QueryValue> values; // 按 select 的顺序
+};
+
+struct QueryAggregate
+{
+    size_t count = 0;
+    int64_t sum = 0;
+    int64_t min = 0; // count 为 0 时 min 与 max 无意义
+    int64_t max = 0;
+
+    [[nodiscard]] double average() const
+    {
+        return count != 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+    }
+};
+
+struct QueryOptions
+{
+    // 并行查询文件的线程数，0 表示使用硬件并发数
+    size_t threads = 0;
+};
+
+// 记录中的一个字段，offset 包含数组元素的偏移
+struct FieldRef
+{
+    const FieldInfo* field;
+    uint16_t offset;
+};
+
+// 按名字查找 table 中的字段，数组元素写作 name[i]；未知字段、保留字段或下标越界时抛出 std::invalid_argument
+FieldRef find_field(BlockKind table, string_view field);
+
+// 规则与命令行中的表名 game_data、forces、cities、legions、characters，其他抛出 std::invalid_argument
+BlockKind parse_table(string_view name);
+// parse_table 的逆操作；Scenario 与 Friendship 分别为 scenario 与 friendship
+string_view table_key(BlockKind table);
+
+// == != < <= > >=，其他抛出 std::invalid_argument
+CompareOp parse_compare_op(string_view text);
+
+// 对一类记录的筛选、投影与聚合。条件直接在 Raw 记录上求值，
+// 不构建任何对象，名字只对匹配的记录解码。查询读取文件映像，尚未写回的修改不可见。
+//
+//   Query(BlockKind::Characters)
+//       .where("status", CompareOp::Equal, static_cast<int>(CharacterStatus::Idle))
+//       .where("command", CompareOp::Greater, 10)
+//       .where("month_to_board", CompareOp::LessEqual, 3)
+//       .select("name")
+//       .run(game);
+class Query
+{
+public:
+    // 只支持 GameData、Forces、Cities、Legions 与 Characters，其余抛出 std::invalid_argument
+    explicit Query(BlockKind table);
+
+    // field 为 record_fields 中的名字，数组元素写作 name[i]。
+    // 只接受数值字段，未知字段或名字、保留字段抛出 std::invalid_argument。多个条件同时满足才算匹配。
+    Query& where(string_view field, CompareOp op, int64_t value);
+
+    // 结果中附带的字段，接受数值与名字字段
+    Query& select(string_view field);
+
+    [[nodiscard]] BlockKind getTable() const
+    {
+        return table;
+    }
+
+    // 空槽位中的记录不匹配任何查询
+    [[nodiscard]] bool matches(const uint8_t* record) const;
+
+    // 把匹配的记录追加到 out，返回追加的个数
+    size_t run(const Raw::Scenario& raw, vector<QueryRow>& out, uint8_t scenario = 0,
+               const ScenarioFile* file = nullptr) const;
+    [[nodiscard]] vector<QueryRow> run(const ScenarioFile& file) const;
+
+    // 按文件并行查询场景文件、存档与 SAVE.DAT，结果按此顺序排列，与线程数无关
+    [[nodiscard]] vector<QueryRow> run(const DragonGameObject& game, const QueryOptions& options = {}) const;
+
+    // 匹配记录中数值字段的统计；field 的写法与 where 相同
+    [[nodiscard]] QueryAggregate aggregate(string_view field, const Raw::Scenario& raw) const;
+    [[nodiscard]] QueryAggregate aggregate(string_view field, const ScenarioFile& file) const;
+    [[nodiscard]] QueryAggregate aggregate(string_view field, const DragonGameObject& game,
+                                           const QueryOptions& options = {}) const;
+
+    // 只计数，等价于 aggregate 的 count
+    [[nodiscard]] size_t count(const DragonGameObject& game, const QueryOptions& options = {}) const;
+
+private:
+    using Column = FieldRef;
+
+    struct Condition
+    {
+        uint16_t offset;
+        FieldType type;
+        CompareOp op;
+        int64_t value;
+    };
+
+    [[nodiscard]] Column column(string_view field) const;
+    [[nodiscard]] Column numericColumn(string_view field) const;
+    void accumulate(const ScenarioFile& file, const Column& column, QueryAggregate& result) const;
+    void accumulate(const Raw::Scenario& raw, const Column& column, QueryAggregate& result) const;
+
+    BlockKind table;
+    vector<Condition> conditions;
+    vector<Column> columns;
+};
+}
@@ -0,0 +1,121 @@
+#include "Query.h"
+#include <gtest/gtest.h>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(Query, MatchModel)
+{
+    auto data_path = fs::current_path() / "tests";
+    ScenarioFile file;
+    ASSERT_TRUE(file.loadFile(data_path / "SINARIO-01.DAT"));
+
+    auto query = Query(BlockKind::Characters)
+                 .where("status", CompareOp::Equal, static_cast<int>(CharacterStatus::Idle))
+                 .where("command", CompareOp::Greater, 10)
+                 .where("month_to_board", CompareOp::LessEqual, 3)
+                 .select("name")
+                 .select("command");
+    const auto rows = query.run(file);
+
+    std::vector<std::pair<uint8_t, const Character*>> expected;
+    for (uint8_t i = 0; i < file.getScenarios().size(); ++i)
+    {
+        for (const auto& c : file.getScenarios()[i].getCharacters())
+        {
+            if (c->getStatus() == CharacterStatus::Idle && c->getCommand() > 10 && c->getMonthToBoard() <= 3)
+            {
+                expected.emplace_back(i, c);
+            }
+        }
+    }
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        EXPECT_EQ(rows[i].file, &file);
+        EXPECT_EQ(rows[i].scenario, expected[i].first);
+        EXPECT_EQ(rows[i].slot, expected[i].second->getIndex());
+        EXPECT_EQ(std::get<std::wstring>(rows[i].values[0]), expected[i].second->getName());
+        EXPECT_EQ(std::get<int64_t>(rows[i].values[1]), expected[i].second->getCommand());
+        EXPECT_EQ(file.getScenarios()[rows[i].scenario].findCharacter(rows[i].slot), expected[i].second);
+    }
+
+    // 数组元素与聚合；剧本开始时没有军团
+    SavedScenarioFile saved;
+    ASSERT_TRUE(saved.loadFile(data_path / "SAVE.DAT"));
+    const auto& legions = saved.getScenarios()[2].getLegions();
+    ASSERT_FALSE(legions.empty());
+    const auto troops = Query(BlockKind::Legions).aggregate("troops.count[0]", saved.getImage()->getScenario(2));
+    EXPECT_EQ(troops.count, legions.size());
+    int64_t sum = 0;
+    for (const auto& legion : legions)
+    {
+        sum += legion->getTroops()[0].getCount();
+    }
+    EXPECT_EQ(troops.sum, sum);
+    EXPECT_LE(troops.min, troops.max);
+
+    EXPECT_THROW(Query(BlockKind::Friendship), std::invalid_argument);
+    EXPECT_THROW(Query(BlockKind::Characters).where("name", CompareOp::Equal, 0), std::invalid_argument);
+    EXPECT_THROW(Query(BlockKind::Characters).where("reserved_1", CompareOp::Equal, 0), std::invalid_argument);
+    EXPECT_THROW(Query(BlockKind::Legions).select("troops.count[6]"), std::invalid_argument);
+    EXPECT_THROW(Query(BlockKind::Legions).select("troops.count[x]"), std::invalid_argument);
+}
+
+TEST(Query, RunAcrossFiles)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto game_path = fs::temp_directory_path() / "Query_game";
+    fs::remove_all(game_path);
+    fs::create_directories(game_path / "SINARIO");
+    fs::create_directories(game_path / "SAVES");
+    for (int i = 1; i <= 6; ++i)
+    {
+        auto name = "SINARIO-0" + std::to_string(i) + ".DAT";
+        fs::copy_file(data_path / name, game_path / "SINARIO" / name);
+    }
+    fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVES" / "SAVE1.DAT");
+    fs::copy_file(data_path / "SAVE.DAT", game_path / "SAVE.DAT");
+
+    DragonGameObject game;
+    ScanOptions scan;
+    scan.mode = LoadMode::Lazy;
+    auto folder = game_path.string();
+    ASSERT_TRUE(game.openGameFolder(folder, scan));
+
+    auto query = Query(BlockKind::Cities).where("soldiers", CompareOp::Greater, 10).select("name");
+    QueryOptions serial;
+    serial.threads = 1;
+    const auto rows = query.run(game, serial);
+    const auto parallel = query.run(game);
+    ASSERT_EQ(rows.size(), parallel.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        EXPECT_EQ(rows[i].file, parallel[i].file);
+        EXPECT_EQ(rows[i].scenario, parallel[i].scenario);
+        EXPECT_EQ(rows[i].slot, parallel[i].slot);
+        EXPECT_EQ(rows[i].values, parallel[i].values);
+    }
+    EXPECT_EQ(rows.front().file, &game.get_scenario_files().front());
+    EXPECT_EQ(rows.back().file, &game.get_default_saved_file());
+    EXPECT_EQ(query.count(game), rows.size());
+
+    size_t expected = 0;
+    for (const auto& file : game.get_scenario_files())
+    {
+        expected += query.run(file).size();
+    }
+    expected += 2 * query.run(game.get_default_saved_file()).size();
+    EXPECT_EQ(rows.size(), expected);
+
+    const auto soldiers = query.aggregate("soldiers", game);
+    EXPECT_EQ(soldiers.count, rows.size());
+    EXPECT_GT(soldiers.min, 10);
+    EXPECT_GT(soldiers.average(), 10.0);
+    // 查询不构建任何场景
+    EXPECT_FALSE(game.get_scenario_files().front().getScenarios().isMaterialized(0));
+
+    fs::remove_all(game_path);
+}
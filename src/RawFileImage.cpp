@@ -0,0 +1,400 @@
+#include "RawFileImage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    runtime_error open_error(const fs::path& filepath)
+    {
+        return runtime_error("open scenario file failed: " + filepath.string());
+    }
+
+#ifdef _WIN32
+    // 映射整个文件，返回映射地址；文件大小通过 size 返回。
+    // exact_size 为 true 时只映射完整大小的场景文件，其余大小返回 nullptr；空文件总是返回 nullptr
+    void* map_file(const fs::path& filepath, size_t& size, const bool exact_size = true)
+    {
+        HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw open_error(filepath);
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size))
+        {
+            CloseHandle(file);
+            throw open_error(filepath);
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+        if (size == 0 || (exact_size && size != Raw::FILE_SIZE))
+        {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) throw open_error(filepath);
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+        CloseHandle(mapping);
+        if (view == nullptr) throw open_error(filepath);
+        return view;
+    }
+
+    // 把整个场景文件读入补零到 Raw::FILE_SIZE 的缓冲区，文件大小通过 size 返回。
+    // 大小不符合 Raw::File 布局（包括读取期间被截断）时返回 false
+    bool read_file(const fs::path& filepath, vector<uint8_t>& buffer, size_t& size)
+    {
+        HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw open_error(filepath);
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size))
+        {
+            CloseHandle(file);
+            throw open_error(filepath);
+        }
+        if (!RawFileImage::isValidFileSize(static_cast<uintmax_t>(file_size.QuadPart)))
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        buffer.assign(Raw::FILE_SIZE, 0);
+        const auto expected = static_cast<size_t>(file_size.QuadPart);
+        size = 0;
+        while (size < expected)
+        {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(size);
+            DWORD read = 0;
+            if (!ReadFile(file, buffer.data() + size, static_cast<DWORD>(expected - size), &read, &overlapped))
+            {
+                if (GetLastError() == ERROR_HANDLE_EOF) break;
+                CloseHandle(file);
+                throw open_error(filepath);
+            }
+            if (read == 0) break;
+            size += read;
+        }
+        CloseHandle(file);
+        return RawFileImage::isValidFileSize(size);
+    }
+
+    void unmap_file(void* view, size_t)
+    {
+        UnmapViewOfFile(view);
+    }
+
+    void* map_file_writable(const fs::path& filepath, size_t& size)
+    {
+        HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw open_error(filepath);
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size))
+        {
+            CloseHandle(file);
+            throw open_error(filepath);
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+        if (!RawFileImage::isValidFileSize(size))
+        {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) throw open_error(filepath);
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        CloseHandle(mapping);
+        if (view == nullptr) throw open_error(filepath);
+        return view;
+    }
+
+    void flush_file(void* view, const size_t offset, const size_t len)
+    {
+        FlushViewOfFile(static_cast<uint8_t*>(view) + offset, len);
+    }
+
+    void write_new_file(const fs::path& filepath, const span<const uint8_t> image, const bool sync)
+    {
+        HANDLE file = CreateFileW(filepath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw open_error(filepath);
+
+        bool ok = true;
+        for (size_t offset = 0; ok && offset < image.size();)
+        {
+            DWORD written = 0;
+            const auto chunk = static_cast<DWORD>(min<size_t>(image.size() - offset, 1u << 30));
+            ok = WriteFile(file, image.data() + offset, chunk, &written, nullptr) && written != 0;
+            offset += written;
+        }
+        if (ok && sync) ok = FlushFileBuffers(file);
+        CloseHandle(file);
+        if (!ok) throw runtime_error("write scenario file failed: " + filepath.string());
+    }
+
+    // Windows 上重命名的元数据由 NTFS 日志保证，目录句柄不支持 FlushFileBuffers
+    void sync_directory(const fs::path&)
+    {
+    }
+#else
+    void* map_file(const fs::path& filepath, size_t& size, const bool exact_size = true)
+    {
+        const int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw open_error(filepath);
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw open_error(filepath);
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size == 0 || (exact_size && size != Raw::FILE_SIZE))
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        // 映射建立后即可关闭文件描述符，避免扫描大量存档时耗尽描述符
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) throw open_error(filepath);
+        return view;
+    }
+
+    bool read_file(const fs::path& filepath, vector<uint8_t>& buffer, size_t& size)
+    {
+        const int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw open_error(filepath);
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw open_error(filepath);
+        }
+        if (!RawFileImage::isValidFileSize(static_cast<uintmax_t>(st.st_size)))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        buffer.assign(Raw::FILE_SIZE, 0);
+        const auto expected = static_cast<size_t>(st.st_size);
+        size = 0;
+        while (size < expected)
+        {
+            const auto n = pread(fd, buffer.data() + size, expected - size, static_cast<off_t>(size));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0)
+            {
+                ::close(fd);
+                throw open_error(filepath);
+            }
+            if (n == 0) break;
+            size += static_cast<size_t>(n);
+        }
+        ::close(fd);
+        return RawFileImage::isValidFileSize(size);
+    }
+
+    void unmap_file(void* view, const size_t size)
+    {
+        munmap(view, size);
+    }
+
+    void* map_file_writable(const fs::path& filepath, size_t& size)
+    {
+        const int fd = ::open(filepath.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) throw open_error(filepath);
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw open_error(filepath);
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (!RawFileImage::isValidFileSize(size))
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) throw open_error(filepath);
+        return view;
+    }
+
+    void flush_file(void* view, const size_t offset, const size_t len)
+    {
+        // msync 要求起始地址按页对齐
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / page_size * page_size;
+        msync(static_cast<uint8_t*>(view) + begin, offset + len - begin, MS_SYNC);
+    }
+
+    void write_new_file(const fs::path& filepath, const span<const uint8_t> image, const bool sync)
+    {
+        const int fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0) throw open_error(filepath);
+
+        bool ok = true;
+        for (size_t offset = 0; ok && offset < image.size();)
+        {
+            const auto n = ::write(fd, image.data() + offset, image.size() - offset);
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) offset += static_cast<size_t>(n);
+        }
+        if (ok && sync) ok = fsync(fd) == 0;
+        ::close(fd);
+        if (!ok) throw runtime_error("write scenario file failed: " + filepath.string());
+    }
+
+    // 重命名只有在所在目录落盘后才能在断电后保留
+    void sync_directory(const fs::path& directory)
+    {
+        const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) throw runtime_error("open directory failed: " + directory.string());
+        const bool ok = fsync(fd) == 0;
+        ::close(fd);
+        if (!ok) throw runtime_error("sync directory failed: " + directory.string());
+    }
+#endif
+}
+
+RawFileImage::RawFileImage(fs::path filepath)
+    : file_path(std::move(filepath))
+{
+}
+
+RawFileImage::~RawFileImage()
+{
+    if (mapping != nullptr)
+    {
+        unmap_file(mapping, file_size);
+    }
+}
+
+RawFileImagePtr RawFileImage::open(const fs::path& filepath, const ImageMode mode)
+{
+    shared_ptr<RawFileImage> image(new RawFileImage(filepath));
+
+    if (mode == ImageMode::Map)
+    {
+        image->mapping = map_file(filepath, image->file_size);
+        if (image->mapping != nullptr)
+        {
+            image->data = static_cast<const uint8_t*>(image->mapping);
+            return image;
+        }
+        if (!isValidFileSize(image->file_size)) return nullptr;
+    }
+
+    // 要求私有副本，或者文件末尾缺少部分保留字节：读入补零的缓冲区
+    if (!read_file(filepath, image->padded, image->file_size)) return nullptr;
+    image->data = image->padded.data();
+    return image;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapping != nullptr)
+    {
+        unmap_file(mapping, size);
+    }
+}
+
+unique_ptr<MappedFile> MappedFile::open(const fs::path& filepath)
+{
+    unique_ptr<MappedFile> file(new MappedFile());
+    file->mapping = map_file(filepath, file->size, false);
+    return file;
+}
+
+WritableFileImage::~WritableFileImage()
+{
+    if (data != nullptr)
+    {
+        unmap_file(data, file_size);
+    }
+}
+
+unique_ptr<WritableFileImage> WritableFileImage::open(const fs::path& filepath)
+{
+    unique_ptr<WritableFileImage> image(new WritableFileImage());
+    image->data = static_cast<uint8_t*>(map_file_writable(filepath, image->file_size));
+    if (image->data == nullptr) return nullptr;
+    return image;
+}
+
+void WritableFileImage::flush(const size_t offset, const size_t len) const
+{
+    if (len == 0 || offset >= file_size) return;
+    flush_file(data, offset, min(len, file_size - offset));
+}
+
+fs::path unique_temp_path(const fs::path& target)
+{
+    thread_local mt19937_64 random(random_device{}());
+    ostringstream suffix;
+    suffix << '.' << hex << setfill('0') << setw(16) << random() << ".tmp";
+    auto path = target;
+    path += suffix.str();
+    return path;
+}
+
+void replace_file_atomically(const fs::path& target, const span<const uint8_t> image, const bool sync)
+{
+    const auto temp_path = unique_temp_path(target);
+    try
+    {
+        write_new_file(temp_path, image, sync);
+        fs::rename(temp_path, target);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        error_code ec;
+        fs::remove(temp_path, ec);
+        throw runtime_error(e.what());
+    }
+    catch (...)
+    {
+        error_code ec;
+        fs::remove(temp_path, ec);
+        throw;
+    }
+    if (sync) sync_directory(target.parent_path());
+}
+}
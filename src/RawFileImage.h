@@ -0,0 +1,199 @@
+#pragma once
+#include "DragonData.h"
+
+#include <algorithm>
+#include <memory>
+#include <span>
+
+namespace DragonData
+{
+struct ByteRange
+{
+    size_t offset;
+    size_t length;
+};
+
+// 文件中发生变化的字节范围，按偏移排序，相邻或重叠的范围会被合并
+class ChangeSet
+{
+public:
+    void add(size_t offset, size_t length)
+    {
+        if (length == 0) return;
+        size_t end = offset + length;
+        auto it = lower_bound(ranges.begin(), ranges.end(), offset,
+                              [](const ByteRange& r, const size_t value) { return r.offset + r.length < value; });
+        while (it != ranges.end() && it->offset <= end)
+        {
+            offset = min(offset, it->offset);
+            end = max(end, it->offset + it->length);
+            it = ranges.erase(it);
+        }
+        ranges.insert(it, {offset, end - offset});
+    }
+
+    [[nodiscard]] const vector<ByteRange>& getRanges() const
+    {
+        return ranges;
+    }
+
+    [[nodiscard]] size_t getByteCount() const
+    {
+        size_t count = 0;
+        for (const auto& range : ranges)
+        {
+            count += range.length;
+        }
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return ranges.empty();
+    }
+
+private:
+    vector<ByteRange> ranges;
+};
+
+// 场景文件的只读映像。ImageMode::Map 时完整大小的文件直接以内存映射方式读取，不做任何拷贝；
+// 末尾缺少保留字节的文件（例如 SINARIO-03.DAT）以及 ImageMode::Copy 时会被读入补零的缓冲区中。
+// 所有指向 Raw 结构体的引用都依赖于此对象，持有 RawFileImagePtr 即可保证映射有效。
+class RawFileImage
+{
+public:
+    ~RawFileImage();
+
+    RawFileImage(const RawFileImage&) = delete;
+    RawFileImage& operator=(const RawFileImage&) = delete;
+
+    // 打开失败时抛出 std::runtime_error；文件大小不符合 Raw::File 布局时返回 nullptr
+    static RawFileImagePtr open(const fs::path& filepath, ImageMode mode = ImageMode::Map);
+
+    [[nodiscard]] static bool isValidFileSize(uintmax_t size)
+    {
+        return size >= Raw::MIN_FILE_SIZE && size <= Raw::FILE_SIZE;
+    }
+
+    [[nodiscard]] const Raw::File& getFile() const
+    {
+        return *reinterpret_cast<const Raw::File*>(data);
+    }
+
+    [[nodiscard]] const Raw::Scenario& getScenario(const size_t index) const
+    {
+        return getFile().scenarios[index];
+    }
+
+    [[nodiscard]] const uint8_t* getData() const
+    {
+        return data;
+    }
+
+    [[nodiscard]] const fs::path& getPath() const
+    {
+        return file_path;
+    }
+
+    [[nodiscard]] size_t getFileSize() const
+    {
+        return file_size;
+    }
+
+    [[nodiscard]] bool isMapped() const
+    {
+        return mapping != nullptr;
+    }
+
+    [[nodiscard]] bool isPadded() const
+    {
+        return file_size < Raw::FILE_SIZE;
+    }
+
+private:
+    explicit RawFileImage(fs::path filepath);
+
+    fs::path file_path;
+    const uint8_t* data = nullptr;
+    size_t file_size = 0;
+    void* mapping = nullptr;
+    vector<uint8_t> padded;
+};
+
+// 只读映射任意大小的文件（例如列式导出的表），空文件的 getData() 为 nullptr
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 打开或映射失败时抛出 std::runtime_error
+    static unique_ptr<MappedFile> open(const fs::path& filepath);
+
+    [[nodiscard]] const uint8_t* getData() const
+    {
+        return static_cast<const uint8_t*>(mapping);
+    }
+
+    [[nodiscard]] size_t getSize() const
+    {
+        return size;
+    }
+
+private:
+    MappedFile() = default;
+
+    void* mapping = nullptr;
+    size_t size = 0;
+};
+
+// 以共享、可写方式映射的场景文件，写入的字节直接落到文件上。
+// 只映射文件的实际长度，不会扩展被截断的文件。
+class WritableFileImage
+{
+public:
+    ~WritableFileImage();
+
+    WritableFileImage(const WritableFileImage&) = delete;
+    WritableFileImage& operator=(const WritableFileImage&) = delete;
+
+    // 打开或映射失败时抛出 std::runtime_error；文件大小不符合 Raw::File 布局时返回 nullptr
+    static unique_ptr<WritableFileImage> open(const fs::path& filepath);
+
+    [[nodiscard]] uint8_t* getData() const
+    {
+        return data;
+    }
+
+    [[nodiscard]] size_t getFileSize() const
+    {
+        return file_size;
+    }
+
+    [[nodiscard]] Raw::Scenario& getScenario(const size_t index) const
+    {
+        return reinterpret_cast<Raw::File*>(data)->scenarios[index];
+    }
+
+    // 把 [offset, offset + len) 范围内的修改同步到磁盘
+    void flush(size_t offset, size_t len) const;
+
+private:
+    WritableFileImage() = default;
+
+    uint8_t* data = nullptr;
+    size_t file_size = 0;
+};
+
+// target 同目录下的临时文件名 <target>.<随机数>.tmp，每次调用都不同，
+// 多个线程或进程同时替换同一文件时不会写到对方的临时文件上
+fs::path unique_temp_path(const fs::path& target);
+
+// 原子地以 image 的全部内容替换 target：先写入同目录下的临时文件，再重命名覆盖 target。
+// 结果只取决于 image，与磁盘上 target 的当前内容无关；读者只会看到完整的旧文件或新文件。
+// sync 为 true 时临时文件在重命名前落盘，重命名后所在目录也落盘。
+// 失败时 target 保持不变并抛出 std::runtime_error。
+void replace_file_atomically(const fs::path& target, span<const uint8_t> image, bool sync);
+}
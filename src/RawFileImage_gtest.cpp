@@ -0,0 +1,137 @@
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <thread>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+namespace
+{
+// target 旁边残留的临时文件数
+size_t temp_files_of(const fs::path& target)
+{
+    const auto prefix = target.filename().string() + ".";
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(target.parent_path()))
+    {
+        const auto name = entry.path().filename().string();
+        if (name.starts_with(prefix) && name.ends_with(".tmp")) ++count;
+    }
+    return count;
+}
+}
+
+TEST(RawFileImage, MapFullSizeFile)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+    EXPECT_TRUE(image->isMapped());
+    EXPECT_FALSE(image->isPadded());
+    EXPECT_EQ(image->getFileSize(), Raw::FILE_SIZE);
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(&image->getScenario(1)), image->getData() + Raw::SCENARIO_DATA_SIZE);
+}
+
+TEST(RawFileImage, PadTruncatedFile)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-03.DAT");
+    ASSERT_TRUE(image);
+    EXPECT_FALSE(image->isMapped());
+    EXPECT_TRUE(image->isPadded());
+    EXPECT_EQ(image->getFileSize(), Raw::FILE_SIZE - 2);
+    EXPECT_EQ(image->getData()[Raw::FILE_SIZE - 1], 0);
+}
+
+TEST(RawFileImage, RejectWrongSize)
+{
+    auto tmp_path = fs::temp_directory_path() / "RawFileImage_short.DAT";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        ofs << "too short";
+    }
+    EXPECT_FALSE(RawFileImage::open(tmp_path));
+    fs::remove(tmp_path);
+
+    EXPECT_THROW(RawFileImage::open(tmp_path), std::runtime_error);
+}
+
+TEST(RawFileImage, ChangeSetMergesRanges)
+{
+    ChangeSet changes;
+    changes.add(100, 10);
+    changes.add(10, 5);
+    changes.add(15, 5);
+    changes.add(105, 20);
+    changes.add(50, 0);
+    ASSERT_EQ(changes.getRanges().size(), 2);
+    EXPECT_EQ(changes.getRanges()[0].offset, 10);
+    EXPECT_EQ(changes.getRanges()[0].length, 10);
+    EXPECT_EQ(changes.getRanges()[1].offset, 100);
+    EXPECT_EQ(changes.getRanges()[1].length, 25);
+    EXPECT_EQ(changes.getByteCount(), 35);
+
+    changes.add(0, 200);
+    ASSERT_EQ(changes.getRanges().size(), 1);
+    EXPECT_EQ(changes.getByteCount(), 200);
+}
+
+TEST(RawFileImage, ReplaceFileAtomically)
+{
+    auto target = fs::temp_directory_path() / "RawFileImage_replace.DAT";
+    fs::copy_file(fs::current_path() / "tests" / "SINARIO-01.DAT", target, fs::copy_options::overwrite_existing);
+
+    // 结果只取决于 image，不保留目标文件原有的字节
+    std::vector<uint8_t> image(Raw::FILE_SIZE, 0x5a);
+    image[16] = 0x01;
+    replace_file_atomically(target, image, true);
+    EXPECT_EQ(temp_files_of(target), 0);
+    const auto replaced = RawFileImage::open(target);
+    ASSERT_TRUE(replaced);
+    EXPECT_EQ(std::memcmp(replaced->getData(), image.data(), image.size()), 0);
+
+    // 写入失败时不留下临时文件
+    const auto missing = fs::temp_directory_path() / "RawFileImage_missing" / "SAVE.DAT";
+    EXPECT_THROW(replace_file_atomically(missing, image, false), std::runtime_error);
+    EXPECT_FALSE(fs::exists(missing.parent_path()));
+    EXPECT_EQ(fs::file_size(target), Raw::FILE_SIZE);
+
+    fs::remove(target);
+}
+
+TEST(RawFileImage, ReplaceFileConcurrently)
+{
+    auto target = fs::temp_directory_path() / "RawFileImage_concurrent.DAT";
+    fs::remove(target);
+    EXPECT_NE(unique_temp_path(target), unique_temp_path(target));
+
+    // 每个线程写入不同的字节，最终文件必须完整地来自其中一个线程
+    constexpr int THREADS = 8;
+    std::vector<std::vector<uint8_t>> images;
+    for (int i = 0; i < THREADS; ++i)
+    {
+        images.emplace_back(Raw::FILE_SIZE, static_cast<uint8_t>(i + 1));
+    }
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < THREADS; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                for (int round = 0; round < 20; ++round)
+                {
+                    replace_file_atomically(target, images[i], false);
+                }
+            });
+        }
+    }
+    EXPECT_EQ(temp_files_of(target), 0);
+    const auto replaced = RawFileImage::open(target);
+    ASSERT_TRUE(replaced);
+    const auto value = replaced->getData()[0];
+    EXPECT_TRUE(std::all_of(replaced->getData(), replaced->getData() + 1024, [value](uint8_t b) { return b == value; }));
+    fs::remove(target);
+}
@@ -0,0 +1,380 @@
+#pragma once
+#include "BlockIndex.h"
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace DragonData
+{
+enum class FieldType : uint8_t
+{
+    UInt8 = 0,
+    UInt16 = 1,
+    UInt24 = 2, // 小端 3 字节，例如势力的资金
+    Name = 3,   // BIG5 编码的名字
+    Bytes = 4,  // 未解析的字节（保留字段）
+};
+
+// Raw 记录中的一个字段；count > 1 表示数组，元素间隔 stride 字节
+struct FieldInfo
+{
+    const char* name;
+    uint16_t offset;
+    uint16_t size;
+    FieldType type;
+    uint8_t count = 1;
+    uint16_t stride = 0;
+
+    [[nodiscard]] constexpr bool isReserved() const
+    {
+        return type == FieldType::Bytes;
+    }
+};
+
+// 每类 Raw 记录的字段表，在编译期生成并校验。
+// Raw::Scenario 只包含不属于任何数据表的保留区域。
+template <typename R>
+struct RecordLayout;
+
+#define LAYOUT_FIELD(R, member, type) \
+    FieldInfo{#member, static_cast<uint16_t>(offsetof(R, member)), sizeof(declval<R&>().member), type}
+#define LAYOUT_ARRAY(R, name, first, type, count, stride)                                                    \
+    FieldInfo{name, static_cast<uint16_t>(offsetof(R, first)), sizeof(declval<R&>().first), type, count, \
+              stride}
+
+template <>
+struct RecordLayout<Raw::GameData>
+{
+    static constexpr BlockKind kind = BlockKind::GameData;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::GameData, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, day, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, month, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, reserved_2, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, year, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::GameData, reserved_3, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, force, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, trust, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, number, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, reserved_4, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, cur_tax_rate, FieldType::UInt16),
+        LAYOUT_ARRAY(Raw::GameData, "cur_conscription", cur_conscription[0], FieldType::UInt16, 3, 2),
+        LAYOUT_FIELD(Raw::GameData, next_tax_rate, FieldType::UInt16),
+        LAYOUT_ARRAY(Raw::GameData, "next_conscription", next_conscription[0], FieldType::UInt16, 3, 2),
+        LAYOUT_FIELD(Raw::GameData, reserved_5, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, total_forces, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::GameData, reserved_6, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::GameData, name, FieldType::Name),
+        LAYOUT_FIELD(Raw::GameData, reserved_7, FieldType::Bytes),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::Force>
+{
+    static constexpr BlockKind kind = BlockKind::Forces;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::Force, status, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, warlord, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, advisor, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, capital, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, cavalries, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Force, infantries, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Force, archers, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Force, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Force, subordinates, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, reserved_2, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Force, money, FieldType::UInt24),
+        LAYOUT_FIELD(Raw::Force, city_count, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, reserved_3, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Force, diplomacy_owner, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Force, reserved_4, FieldType::Bytes),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::Friendship>
+{
+    static constexpr BlockKind kind = BlockKind::Friendship;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_ARRAY(Raw::Friendship, "friendship", friendship[0], FieldType::UInt8, 24, 1),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::City>
+{
+    static constexpr BlockKind kind = BlockKind::Cities;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::City, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::City, force, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::City, name, FieldType::Name),
+        LAYOUT_FIELD(Raw::City, axis.x, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::City, axis.y, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::City, max_productivity, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::City, cur_productivity, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::City, increase, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::City, anti_disaster, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::City, soldiers, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::City, reserved_2, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::City, city_type, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::City, affairs_owner, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::City, reserved_3, FieldType::Bytes),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::Legion>
+{
+    static constexpr BlockKind kind = BlockKind::Legions;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::Legion, state, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Legion, force, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Legion, leader, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Legion, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Legion, total_soldier, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Legion, morale, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Legion, reserved_2, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Legion, current_axis.x, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Legion, current_axis.y, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Legion, reserved_3, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Legion, target_axis.x, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Legion, target_axis.y, FieldType::UInt16),
+        LAYOUT_FIELD(Raw::Legion, reserved_4, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Legion, target_city, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Legion, reserved_5, FieldType::Bytes),
+        LAYOUT_ARRAY(Raw::Legion, "troops.count", troops[0].count, FieldType::UInt16, 6, sizeof(Raw::Troop)),
+        LAYOUT_ARRAY(Raw::Legion, "troops.troop_type", troops[0].troop_type, FieldType::UInt16, 6,
+                     sizeof(Raw::Troop)),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::Character>
+{
+    static constexpr BlockKind kind = BlockKind::Characters;
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::Character, property, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, avatar, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, name, FieldType::Name),
+        LAYOUT_FIELD(Raw::Character, alias, FieldType::Name),
+        LAYOUT_FIELD(Raw::Character, siege_ability, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, field_ability, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, naval_ability, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, battle_ability, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, command, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, politics, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Character, status, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, month_to_board, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, force_next, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, reserved_2, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Character, force_or_capture, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, force_origin, FieldType::UInt8),
+        LAYOUT_FIELD(Raw::Character, reserved_3, FieldType::Bytes),
+    };
+};
+
+template <>
+struct RecordLayout<Raw::Scenario>
+{
+    static constexpr BlockKind kind = BlockKind::Scenario;
+    // 不属于任何数据表的区域
+    static constexpr FieldInfo fields[] = {
+        LAYOUT_FIELD(Raw::Scenario, reserved_1, FieldType::Bytes),
+        LAYOUT_FIELD(Raw::Scenario, reserved_2, FieldType::Bytes),
+    };
+};
+
+#undef LAYOUT_ARRAY
+#undef LAYOUT_FIELD
+
+// 数值字段的宽度；Name 与 Bytes 的宽度由字段决定，返回 0
+constexpr size_t field_width(const FieldType type)
+{
+    switch (type)
+    {
+    case FieldType::UInt8:
+        return 1;
+    case FieldType::UInt16:
+        return 2;
+    case FieldType::UInt24:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+// 字段表是否恰好覆盖记录中的每个字节一次，且数值字段的宽度与类型一致
+template <typename R>
+constexpr bool covers_record()
+{
+    array<uint8_t, sizeof(R)> used{};
+    for (const auto& field : RecordLayout<R>::fields)
+    {
+        const auto width = field_width(field.type);
+        if (field.count == 0 || (width != 0 && width != field.size)) return false;
+        for (size_t element = 0; element < field.count; ++element)
+        {
+            for (size_t i = 0; i < field.size; ++i)
+            {
+                const auto at = field.offset + element * field.stride + i;
+                if (at >= sizeof(R) || used[at]++ != 0) return false;
+            }
+        }
+    }
+    for (const auto n : used)
+    {
+        if (n != 1) return false;
+    }
+    return true;
+}
+
+static_assert(covers_record<Raw::GameData>());
+static_assert(covers_record<Raw::Force>());
+static_assert(covers_record<Raw::Friendship>());
+static_assert(covers_record<Raw::City>());
+static_assert(covers_record<Raw::Legion>());
+static_assert(covers_record<Raw::Character>());
+
+// 按名字取字段，在常量表达式中使用时名字拼错会导致编译失败
+template <typename R>
+constexpr const FieldInfo& layout_field(const string_view name)
+{
+    for (const auto& field : RecordLayout<R>::fields)
+    {
+        if (name == field.name) return field;
+    }
+    throw invalid_argument("unknown field");
+}
+
+// 文件中的多字节数值均为小端序；Name 与 Bytes 读作 0
+template <FieldType T>
+constexpr int64_t read_field(const uint8_t* p)
+{
+    if constexpr (T == FieldType::UInt8) return p[0];
+    else if constexpr (T == FieldType::UInt16) return p[0] | p[1] << 8;
+    else if constexpr (T == FieldType::UInt24) return p[0] | p[1] << 8 | p[2] << 16;
+    else return 0;
+}
+
+constexpr int64_t read_field(const uint8_t* p, const FieldType type)
+{
+    switch (type)
+    {
+    case FieldType::UInt8:
+        return read_field<FieldType::UInt8>(p);
+    case FieldType::UInt16:
+        return read_field<FieldType::UInt16>(p);
+    case FieldType::UInt24:
+        return read_field<FieldType::UInt24>(p);
+    default:
+        return 0;
+    }
+}
+
+// 按小端序写入数值字段，超出字段宽度时抛出 std::out_of_range；Name 与 Bytes 字段不能按数值写入
+constexpr void write_field(uint8_t* p, const FieldType type, const int64_t value)
+{
+    if (type == FieldType::Name || type == FieldType::Bytes) throw invalid_argument("field is not numeric");
+    const auto width = field_width(type);
+    if (value < 0 || value >= int64_t{1} << width * 8) throw out_of_range("value does not fit field");
+    for (size_t i = 0; i < width; ++i)
+    {
+        p[i] = static_cast<uint8_t>(value >> i * 8);
+    }
+}
+
+// 每类记录的字段表，覆盖记录中的每个字节。
+// BlockKind::Scenario 只包含不属于任何数据表的保留区域，视为一条记录。
+constexpr span<const FieldInfo> record_fields(const BlockKind kind)
+{
+    switch (kind)
+    {
+    case BlockKind::Scenario:
+        return RecordLayout<Raw::Scenario>::fields;
+    case BlockKind::GameData:
+        return RecordLayout<Raw::GameData>::fields;
+    case BlockKind::Forces:
+        return RecordLayout<Raw::Force>::fields;
+    case BlockKind::Friendship:
+        return RecordLayout<Raw::Friendship>::fields;
+    case BlockKind::Cities:
+        return RecordLayout<Raw::City>::fields;
+    case BlockKind::Legions:
+        return RecordLayout<Raw::Legion>::fields;
+    case BlockKind::Characters:
+        return RecordLayout<Raw::Character>::fields;
+    }
+    throw invalid_argument("unknown block kind");
+}
+
+// 记录的大小与个数；BlockKind::Scenario 为整个场景与 1
+constexpr size_t record_size(const BlockKind kind)
+{
+    switch (kind)
+    {
+    case BlockKind::Scenario:
+        return sizeof(Raw::Scenario);
+    case BlockKind::GameData:
+        return sizeof(Raw::GameData);
+    case BlockKind::Forces:
+        return sizeof(Raw::Force);
+    case BlockKind::Friendship:
+        return sizeof(Raw::Friendship);
+    case BlockKind::Cities:
+        return sizeof(Raw::City);
+    case BlockKind::Legions:
+        return sizeof(Raw::Legion);
+    case BlockKind::Characters:
+        return sizeof(Raw::Character);
+    }
+    throw invalid_argument("unknown block kind");
+}
+
+constexpr size_t record_count(const BlockKind kind)
+{
+    switch (kind)
+    {
+    case BlockKind::Scenario:
+    case BlockKind::GameData:
+        return 1;
+    case BlockKind::Forces:
+        return extent_v<decltype(Raw::Scenario::forces)>;
+    case BlockKind::Friendship:
+        return extent_v<decltype(Raw::Scenario::friendship)>;
+    case BlockKind::Cities:
+        return extent_v<decltype(Raw::Scenario::cities)>;
+    case BlockKind::Legions:
+        return extent_v<decltype(Raw::Scenario::legions)>;
+    case BlockKind::Characters:
+        return extent_v<decltype(Raw::Scenario::characters)>;
+    }
+    throw invalid_argument("unknown block kind");
+}
+
+// 数据块在 Raw::Scenario 中的偏移，与 block_span 一致
+constexpr size_t block_offset(const BlockKind kind)
+{
+    switch (kind)
+    {
+    case BlockKind::Scenario:
+        return 0;
+    case BlockKind::GameData:
+        return offsetof(Raw::Scenario, game_data);
+    case BlockKind::Forces:
+        return offsetof(Raw::Scenario, forces);
+    case BlockKind::Friendship:
+        return offsetof(Raw::Scenario, friendship);
+    case BlockKind::Cities:
+        return offsetof(Raw::Scenario, cities);
+    case BlockKind::Legions:
+        return offsetof(Raw::Scenario, legions);
+    case BlockKind::Characters:
+        return offsetof(Raw::Scenario, characters);
+    }
+    throw invalid_argument("unknown block kind");
+}
+}
@@ -0,0 +1,170 @@
+#include "ScenarioDiff.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    const uint8_t* field_data(const uint8_t* record, const FieldInfo& field, const size_t element)
+    {
+        return record + field.offset + element * field.stride;
+    }
+
+    // 返回 [begin, end) 中第一个不同字节的偏移，没有时返回 end。
+    // 先以 64 字节为单位跳过相同的区域（libc 的 memcmp 使用 SIMD），再按 8 字节定位。
+    size_t find_mismatch(const uint8_t* a, const uint8_t* b, size_t begin, const size_t end)
+    {
+        constexpr size_t CHUNK = 64;
+        while (begin + CHUNK <= end && memcmp(a + begin, b + begin, CHUNK) == 0)
+        {
+            begin += CHUNK;
+        }
+        for (; begin + sizeof(uint64_t) <= end; begin += sizeof(uint64_t))
+        {
+            uint64_t x, y;
+            memcpy(&x, a + begin, sizeof(x));
+            memcpy(&y, b + begin, sizeof(y));
+            if (x != y) break;
+        }
+        while (begin < end && a[begin] == b[begin])
+        {
+            ++begin;
+        }
+        return begin;
+    }
+
+    // 按记录类型实例化：字段表是编译期常量，偏移与宽度直接编进比较代码
+    template <typename R>
+    size_t diff_record(const uint8_t* a, const uint8_t* b, const FieldChange& key, vector<FieldChange>& out,
+                       const DiffOptions& options)
+    {
+        size_t count = 0;
+        for (const auto& field : RecordLayout<R>::fields)
+        {
+            if (field.isReserved() && !options.include_reserved) continue;
+            for (uint8_t element = 0; element < field.count; ++element)
+            {
+                const auto* x = field_data(a, field, element);
+                const auto* y = field_data(b, field, element);
+                if (memcmp(x, y, field.size) == 0) continue;
+
+                auto change = key;
+                change.element = element;
+                change.field = &field;
+                change.before = read_field(x, field.type);
+                change.after = read_field(y, field.type);
+                out.push_back(change);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    using DiffRecord = size_t (*)(const uint8_t*, const uint8_t*, const FieldChange&, vector<FieldChange>&,
+                                  const DiffOptions&);
+
+    // 按 BlockKind 的取值排列
+    constexpr DiffRecord DIFF_RECORD[BLOCK_KIND_COUNT] = {
+        diff_record<Raw::Scenario>, diff_record<Raw::GameData>, diff_record<Raw::Force>,
+        diff_record<Raw::Friendship>, diff_record<Raw::City>, diff_record<Raw::Legion>,
+        diff_record<Raw::Character>,
+    };
+}
+
+bool is_record_occupied(const BlockKind kind, const uint8_t* record)
+{
+    switch (kind)
+    {
+    case BlockKind::Forces:
+        return reinterpret_cast<const Raw::Force*>(record)->status != 0;
+    case BlockKind::Cities:
+    {
+        const auto& axis = reinterpret_cast<const Raw::City*>(record)->axis;
+        return axis.x != 0 && axis.y != 0;
+    }
+    case BlockKind::Legions:
+    {
+        const auto& axis = reinterpret_cast<const Raw::Legion*>(record)->current_axis;
+        return axis.x != 0 && axis.y != 0;
+    }
+    case BlockKind::Characters:
+        return reinterpret_cast<const Raw::Character*>(record)->name.name[0] != 0;
+    default:
+        return true;
+    }
+}
+
+wstring field_text(const Raw::Scenario& raw, const FieldChange& change)
+{
+    const auto* record = block_span(raw, change.table).data + change.record * record_size(change.table);
+    const auto& field = *change.field;
+    const auto* p = field_data(record, field, change.element);
+    switch (field.type)
+    {
+    case FieldType::Name:
+        return intern_name(reinterpret_cast<const char*>(p), field.size);
+    case FieldType::Bytes:
+    {
+        wostringstream os;
+        os << hex << setfill(L'0');
+        for (size_t i = 0; i < field.size; ++i)
+        {
+            os << setw(2) << static_cast<unsigned>(p[i]);
+        }
+        return os.str();
+    }
+    default:
+        return to_wstring(read_field(p, field.type));
+    }
+}
+
+size_t diff_scenarios(const Raw::Scenario& before, const Raw::Scenario& after, vector<FieldChange>& out,
+                      const DiffOptions& options, const uint8_t scenario)
+{
+    if (memcmp(&before, &after, sizeof(before)) == 0) return 0;
+
+    size_t count = 0;
+    for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+    {
+        const auto block = static_cast<BlockKind>(kind);
+        FieldChange key{block, scenario, 0, 0, nullptr, 0, 0};
+        const auto diff_record = DIFF_RECORD[kind];
+        const auto a = block_span(before, block);
+        const auto b = block_span(after, block);
+
+        // 场景本身只剩下不属于数据表的保留区域
+        if (block == BlockKind::Scenario)
+        {
+            if (options.include_reserved) count += diff_record(a.data, b.data, key, out, options);
+            continue;
+        }
+
+        const auto size = record_size(block);
+        for (size_t offset = 0; (offset = find_mismatch(a.data, b.data, offset, a.size)) < a.size;)
+        {
+            const auto record = offset / size;
+            key.record = static_cast<uint8_t>(record);
+            count += diff_record(a.data + record * size, b.data + record * size, key, out, options);
+            offset = (record + 1) * size;
+        }
+    }
+    return count;
+}
+
+size_t diff_files(const Raw::File& before, const Raw::File& after, vector<FieldChange>& out,
+                  const DiffOptions& options)
+{
+    size_t count = 0;
+    for (uint8_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        count += diff_scenarios(before.scenarios[i], after.scenarios[i], out, options, i);
+    }
+    return count;
+}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "RawLayout.h"
+
+namespace DragonData
+{
+// 记录是否有效，与 Scenario 构造时跳过空槽位的规则一致；GameData 与 Friendship 总是有效
+bool is_record_occupied(BlockKind kind, const uint8_t* record);
+
+struct FieldChange
+{
+    BlockKind table;
+    uint8_t scenario;
+    uint8_t record; // 原始槽位
+    uint8_t element;
+    const FieldInfo* field;
+    // 数值字段的新旧值；Name 和 Bytes 字段为 0，可用 field_text 取得内容
+    int64_t before;
+    int64_t after;
+};
+
+// 读取 FieldChange 指向的字段，数值按十进制，名字解码，其余按十六进制
+wstring field_text(const Raw::Scenario& raw, const FieldChange& change);
+
+struct DiffOptions
+{
+    // 是否报告保留字节的变化，游戏运行时会改写其中的部分字节
+    bool include_reserved = false;
+};
+
+// 比较两个场景，把字段级的变化追加到 out，返回追加的个数。
+// 先按块比较原始字节，未改变的记录不会逐字段比较。
+size_t diff_scenarios(const Raw::Scenario& before, const Raw::Scenario& after, vector<FieldChange>& out,
+                      const DiffOptions& options = {}, uint8_t scenario = 0);
+
+// 比较文件中的全部场景
+size_t diff_files(const Raw::File& before, const Raw::File& after, vector<FieldChange>& out,
+                  const DiffOptions& options = {});
+}
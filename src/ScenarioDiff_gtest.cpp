@@ -0,0 +1,128 @@
+#include "ScenarioDiff.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(ScenarioDiff, FieldsCoverRecords)
+{
+    for (size_t kind = 0; kind < BLOCK_KIND_COUNT; ++kind)
+    {
+        const auto block = static_cast<BlockKind>(kind);
+        std::vector<int> covered(record_size(block), 0);
+        for (const auto& field : record_fields(block))
+        {
+            for (size_t element = 0; element < field.count; ++element)
+            {
+                for (size_t i = 0; i < field.size; ++i)
+                {
+                    ++covered.at(field.offset + element * field.stride + i);
+                }
+            }
+        }
+        if (block == BlockKind::Scenario)
+        {
+            EXPECT_EQ(std::count(covered.begin(), covered.end(), 1),
+                      sizeof(Raw::Scenario::reserved_1) + sizeof(Raw::Scenario::reserved_2));
+            continue;
+        }
+        EXPECT_TRUE(std::all_of(covered.begin(), covered.end(), [](int n) { return n == 1; })) << kind;
+        EXPECT_EQ(record_size(block) * record_count(block), block_span(Raw::Scenario{}, block).size);
+    }
+}
+
+TEST(ScenarioDiff, LayoutLookup)
+{
+    static_assert(layout_field<Raw::Force>("money").type == FieldType::UInt24);
+    static_assert(layout_field<Raw::Legion>("troops.troop_type").count == 6);
+    static_assert(record_fields(BlockKind::Cities).data() == RecordLayout<Raw::City>::fields);
+
+    const uint8_t bytes[] = {0x34, 0x12, 0xff};
+    EXPECT_EQ(read_field<FieldType::UInt8>(bytes), 0x34);
+    EXPECT_EQ(read_field<FieldType::UInt16>(bytes), 0x1234);
+    EXPECT_EQ(read_field(bytes, FieldType::UInt24), 0xff1234);
+    EXPECT_EQ(read_field(bytes, FieldType::Name), 0);
+    EXPECT_THROW((void)layout_field<Raw::City>("unknown"), std::invalid_argument);
+}
+
+TEST(ScenarioDiff, ReportFieldChanges)
+{
+    auto data_path = fs::current_path() / "tests";
+    const auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+    const auto& before = image->getScenario(0);
+
+    std::vector<FieldChange> changes;
+    EXPECT_EQ(diff_scenarios(before, before, changes), 0);
+    EXPECT_TRUE(changes.empty());
+
+    auto after = std::make_unique<Raw::Scenario>(before);
+    after->characters[5].command = before.characters[5].command + 1;
+    after->forces[2].money[2] ^= 1;
+    Big5Table::instance().encode(L"龍城", after->cities[10].name.name, sizeof(Raw::Name::name));
+    after->legions[3].troops[4].count ^= 0x100;
+    after->reserved_2[10] ^= 0xff;
+    after->characters[7].reserved_1[0] ^= 1;
+
+    EXPECT_EQ(diff_scenarios(before, *after, changes, {}, 2), 4);
+    ASSERT_EQ(changes.size(), 4);
+
+    EXPECT_EQ(changes[0].table, BlockKind::Forces);
+    EXPECT_EQ(changes[0].scenario, 2);
+    EXPECT_EQ(changes[0].record, 2);
+    EXPECT_STREQ(changes[0].field->name, "money");
+    EXPECT_EQ(changes[0].after ^ changes[0].before, 0x10000);
+
+    EXPECT_EQ(changes[1].table, BlockKind::Cities);
+    EXPECT_EQ(changes[1].record, 10);
+    EXPECT_STREQ(changes[1].field->name, "name");
+    EXPECT_EQ(field_text(*after, changes[1]), L"龍城");
+    EXPECT_EQ(field_text(before, changes[1]), intern_name(before.cities[10].name.name, 6));
+
+    EXPECT_EQ(changes[2].table, BlockKind::Legions);
+    EXPECT_STREQ(changes[2].field->name, "troops.count");
+    EXPECT_EQ(changes[2].element, 4);
+    EXPECT_EQ(changes[2].after, after->legions[3].troops[4].count);
+
+    EXPECT_EQ(changes[3].table, BlockKind::Characters);
+    EXPECT_EQ(changes[3].record, 5);
+    EXPECT_STREQ(changes[3].field->name, "command");
+    EXPECT_EQ(changes[3].after, changes[3].before + 1);
+    EXPECT_EQ(field_text(*after, changes[3]), std::to_wstring(changes[3].after));
+
+    changes.clear();
+    EXPECT_EQ(diff_scenarios(before, *after, changes, {.include_reserved = true}), 6);
+    EXPECT_TRUE(std::any_of(changes.begin(), changes.end(), [](const FieldChange& change)
+    {
+        return change.table == BlockKind::Scenario && std::string(change.field->name) == "reserved_2";
+    }));
+}
+
+TEST(ScenarioDiff, ApplyingChangesReproducesTarget)
+{
+    auto data_path = fs::current_path() / "tests";
+    const auto source = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    const auto saved = RawFileImage::open(data_path / "SAVE.DAT");
+    ASSERT_TRUE(source && saved);
+
+    std::vector<FieldChange> changes;
+    ASSERT_GT(diff_files(source->getFile(), saved->getFile(), changes, {.include_reserved = true}), 0);
+
+    auto patched = std::make_unique<Raw::File>(source->getFile());
+    for (const auto& change : changes)
+    {
+        const auto& to = saved->getScenario(change.scenario);
+        auto& from = patched->scenarios[change.scenario];
+        const auto offset = change.record * record_size(change.table) + change.field->offset +
+            change.element * change.field->stride;
+        const auto* src = block_span(to, change.table).data + offset;
+        auto* dst = const_cast<uint8_t*>(block_span(from, change.table).data) + offset;
+        ASSERT_NE(std::memcmp(dst, src, change.field->size), 0);
+        std::memcpy(dst, src, change.field->size);
+    }
+    EXPECT_EQ(std::memcmp(patched.get(), &saved->getFile(), sizeof(Raw::File)), 0);
+}
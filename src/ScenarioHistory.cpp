@@ -0,0 +1,235 @@
+#include "ScenarioHistory.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace std;
+
+namespace DragonData
+{
+ScenarioSnapshot::ScenarioSnapshot(const Raw::Scenario& raw)
+{
+    const auto* data = reinterpret_cast<const uint8_t*>(&raw);
+    for (size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        // 最后一页不满，多出的字节为 0
+        auto page = make_shared<Page>();
+        const auto offset = i * PAGE_SIZE;
+        memcpy(page->data(), data + offset, min(PAGE_SIZE, sizeof(Raw::Scenario) - offset));
+        pages[i] = std::move(page);
+    }
+}
+
+void ScenarioSnapshot::read(size_t offset, span<uint8_t> out) const
+{
+    if (offset > sizeof(Raw::Scenario) || out.size() > sizeof(Raw::Scenario) - offset)
+    {
+        throw out_of_range("read past end of scenario");
+    }
+    while (!out.empty())
+    {
+        const auto in_page = offset % PAGE_SIZE;
+        const auto n = min(out.size(), PAGE_SIZE - in_page);
+        memcpy(out.data(), pages[offset / PAGE_SIZE]->data() + in_page, n);
+        offset += n;
+        out = out.subspan(n);
+    }
+}
+
+uint8_t* ScenarioSnapshot::mutablePage(const size_t page)
+{
+    auto& slot = pages[page];
+    // 只被本副本引用的页可以原地修改，否则先复制
+    if (slot.use_count() > 1) slot = make_shared<Page>(*slot);
+    return const_cast<uint8_t*>(slot->data());
+}
+
+void ScenarioSnapshot::write(size_t offset, span<const uint8_t> data)
+{
+    if (offset > sizeof(Raw::Scenario) || data.size() > sizeof(Raw::Scenario) - offset)
+    {
+        throw out_of_range("write past end of scenario");
+    }
+    while (!data.empty())
+    {
+        const auto page = offset / PAGE_SIZE;
+        const auto in_page = offset % PAGE_SIZE;
+        const auto n = min(data.size(), PAGE_SIZE - in_page);
+        // 内容相同的写入不复制页，撤销后重新写入旧值时仍与之前的修订共享
+        if (memcmp(pages[page]->data() + in_page, data.data(), n) != 0)
+        {
+            memcpy(mutablePage(page) + in_page, data.data(), n);
+        }
+        offset += n;
+        data = data.subspan(n);
+    }
+}
+
+size_t ScenarioSnapshot::recordOffset(const BlockKind kind, const size_t slot)
+{
+    if (slot >= record_count(kind)) throw out_of_range("record slot out of range");
+    return block_offset(kind) + slot * record_size(kind);
+}
+
+int64_t ScenarioSnapshot::getField(const BlockKind kind, const size_t slot, const FieldInfo& field,
+                                   const size_t element) const
+{
+    if (element >= field.count) throw out_of_range("field element out of range");
+    uint8_t value[4] = {};
+    const auto width = field_width(field.type);
+    read(recordOffset(kind, slot) + field.offset + element * field.stride, {value, width});
+    return read_field(value, field.type);
+}
+
+void ScenarioSnapshot::setField(const BlockKind kind, const size_t slot, const FieldInfo& field, const int64_t value,
+                                const size_t element)
+{
+    if (element >= field.count) throw out_of_range("field element out of range");
+    uint8_t bytes[4] = {};
+    write_field(bytes, field.type, value);
+    write(recordOffset(kind, slot) + field.offset + element * field.stride, {bytes, field_width(field.type)});
+}
+
+void ScenarioSnapshot::copyTo(Raw::Scenario& out) const
+{
+    read(0, {reinterpret_cast<uint8_t*>(&out), sizeof(out)});
+}
+
+vector<size_t> ScenarioSnapshot::changedPages(const ScenarioSnapshot& other) const
+{
+    vector<size_t> result;
+    for (size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        if (pages[i] == other.pages[i]) continue;
+        if (*pages[i] != *other.pages[i]) result.push_back(i);
+    }
+    return result;
+}
+
+size_t ScenarioSnapshot::sharedPageCount(const ScenarioSnapshot& other) const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        if (pages[i] == other.pages[i]) ++count;
+    }
+    return count;
+}
+
+ScenarioHistory::ScenarioHistory(const Raw::Scenario& raw)
+    : work(raw)
+{
+    revisions.push_back({work, NO_PARENT, {}});
+    branch_heads[branch_name] = 0;
+}
+
+bool ScenarioHistory::isDirty() const
+{
+    return !work.changedPages(revisions[current].snapshot).empty();
+}
+
+void ScenarioHistory::moveTo(const size_t id)
+{
+    current = id;
+    branch_heads[branch_name] = id;
+    work = revisions[id].snapshot;
+}
+
+size_t ScenarioHistory::commit(string label)
+{
+    if (!isDirty()) return current;
+    revisions.push_back({work, current, std::move(label)});
+    redo_stack.clear();
+    moveTo(revisions.size() - 1);
+    return current;
+}
+
+void ScenarioHistory::revert()
+{
+    work = revisions[current].snapshot;
+}
+
+bool ScenarioHistory::undo()
+{
+    if (!canUndo())
+    {
+        revert();
+        return false;
+    }
+    redo_stack.push_back(current);
+    moveTo(revisions[current].parent);
+    return true;
+}
+
+bool ScenarioHistory::redo()
+{
+    if (!canRedo())
+    {
+        revert();
+        return false;
+    }
+    const auto id = redo_stack.back();
+    redo_stack.pop_back();
+    moveTo(id);
+    return true;
+}
+
+void ScenarioHistory::branch(const string& name)
+{
+    if (branch_heads.contains(name)) throw invalid_argument("branch already exists: " + name);
+    branch_heads[name] = current;
+    branch_name = name;
+    redo_stack.clear();
+}
+
+void ScenarioHistory::checkout(const string& name)
+{
+    const auto id = branch_heads.at(name);
+    branch_name = name;
+    redo_stack.clear();
+    moveTo(id);
+}
+
+vector<string> ScenarioHistory::branches() const
+{
+    vector<string> result;
+    result.reserve(branch_heads.size());
+    for (const auto& [name, id] : branch_heads)
+    {
+        result.push_back(name);
+    }
+    return result;
+}
+
+size_t ScenarioHistory::diff(const size_t from, const size_t to, vector<FieldChange>& out,
+                             const DiffOptions& options) const
+{
+    const auto& before = revision(from).snapshot;
+    const auto& after = revision(to).snapshot;
+    if (before.changedPages(after).empty()) return 0;
+    const auto a = make_unique<Raw::Scenario>();
+    const auto b = make_unique<Raw::Scenario>();
+    before.copyTo(*a);
+    after.copyTo(*b);
+    return diff_scenarios(*a, *b, out, options);
+}
+
+size_t ScenarioHistory::uniquePageCount() const
+{
+    unordered_set<const ScenarioSnapshot::Page*> unique;
+    const auto collect = [&unique](const ScenarioSnapshot& snapshot)
+    {
+        for (const auto& page : snapshot.pages)
+        {
+            unique.insert(page.get());
+        }
+    };
+    for (const auto& item : revisions)
+    {
+        collect(item.snapshot);
+    }
+    collect(work);
+    return unique.size();
+}
+}
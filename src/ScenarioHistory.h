@@ -0,0 +1,155 @@
+#pragma once
+#include "ScenarioDiff.h"
+
+#include <map>
+
+namespace DragonData
+{
+// 写时复制的场景映像：Raw::Scenario 按 PAGE_SIZE 字节分页，复制只复制页表，
+// 写入时只复制被写到且仍与其他副本共享的页。可以在多个线程中同时读取，写入须独占。
+class ScenarioSnapshot
+{
+public:
+    static constexpr size_t PAGE_SIZE = 256;
+    static constexpr size_t PAGE_COUNT = (sizeof(Raw::Scenario) + PAGE_SIZE - 1) / PAGE_SIZE;
+    using Page = array<uint8_t, PAGE_SIZE>;
+
+    explicit ScenarioSnapshot(const Raw::Scenario& raw);
+
+    // 越过场景末尾时抛出 std::out_of_range
+    void read(size_t offset, span<uint8_t> out) const;
+    void write(size_t offset, span<const uint8_t> data);
+
+    template <typename R>
+    [[nodiscard]] R getRecord(const size_t slot) const
+    {
+        R record;
+        read(recordOffset(RecordLayout<R>::kind, slot), {reinterpret_cast<uint8_t*>(&record), sizeof(R)});
+        return record;
+    }
+
+    template <typename R>
+    void setRecord(const size_t slot, const R& record)
+    {
+        write(recordOffset(RecordLayout<R>::kind, slot), {reinterpret_cast<const uint8_t*>(&record), sizeof(R)});
+    }
+
+    // 数值字段；Name 与 Bytes 字段读作 0、不能写入，规则同 read_field 与 write_field
+    [[nodiscard]] int64_t getField(BlockKind kind, size_t slot, const FieldInfo& field, size_t element = 0) const;
+    void setField(BlockKind kind, size_t slot, const FieldInfo& field, int64_t value, size_t element = 0);
+
+    void copyTo(Raw::Scenario& out) const;
+
+    // 与 other 内容不同的页，按页号排序；共享的页直接跳过，不比较内容
+    [[nodiscard]] vector<size_t> changedPages(const ScenarioSnapshot& other) const;
+
+    [[nodiscard]] size_t sharedPageCount(const ScenarioSnapshot& other) const;
+
+    // kind 表中第 slot 条记录在场景中的偏移，越界时抛出 std::out_of_range
+    [[nodiscard]] static size_t recordOffset(BlockKind kind, size_t slot);
+
+private:
+    friend class ScenarioHistory;
+
+    uint8_t* mutablePage(size_t page);
+
+    array<shared_ptr<const Page>, PAGE_COUNT> pages;
+};
+
+// 场景的修订历史。每个修订保存一份 ScenarioSnapshot，与父修订共享未修改的页，
+// 因此每个修订的内存开销是一张页表加上被修改的页。
+// 修改先写入工作副本，commit 后成为当前修订的子修订。undo/redo 沿父修订移动；
+// 撤销后再提交会放弃重做记录，被放弃的修订仍可按修订号取得。
+// 每个分支记录自己的当前修订，切换分支时工作副本随之切换。不是线程安全的。
+class ScenarioHistory
+{
+public:
+    static constexpr size_t NO_PARENT = SIZE_MAX;
+
+    struct Revision
+    {
+        ScenarioSnapshot snapshot;
+        size_t parent;
+        string label;
+    };
+
+    // 修订 0 为 raw 本身，位于分支 main
+    explicit ScenarioHistory(const Raw::Scenario& raw);
+
+    [[nodiscard]] ScenarioSnapshot& working()
+    {
+        return work;
+    }
+
+    [[nodiscard]] const ScenarioSnapshot& working() const
+    {
+        return work;
+    }
+
+    // 工作副本是否有未提交的修改
+    [[nodiscard]] bool isDirty() const;
+
+    // 提交工作副本，返回新修订号；没有修改时不创建修订，返回当前修订号
+    size_t commit(string label = {});
+    // 丢弃未提交的修改
+    void revert();
+
+    // 未提交的修改会被丢弃；没有可撤销或重做的修订时返回 false
+    bool undo();
+    bool redo();
+
+    [[nodiscard]] bool canUndo() const
+    {
+        return revisions[current].parent != NO_PARENT;
+    }
+
+    [[nodiscard]] bool canRedo() const
+    {
+        return !redo_stack.empty();
+    }
+
+    // 在当前修订上创建分支并切换过去，名字已存在时抛出 std::invalid_argument
+    void branch(const string& name);
+    // 切换到分支的当前修订，丢弃未提交的修改；没有该分支时抛出 std::out_of_range
+    void checkout(const string& name);
+
+    [[nodiscard]] const string& currentBranch() const
+    {
+        return branch_name;
+    }
+
+    [[nodiscard]] vector<string> branches() const;
+
+    [[nodiscard]] size_t head() const
+    {
+        return current;
+    }
+
+    // id 不存在时抛出 std::out_of_range
+    [[nodiscard]] const Revision& revision(size_t id) const
+    {
+        return revisions.at(id);
+    }
+
+    [[nodiscard]] size_t revisionCount() const
+    {
+        return revisions.size();
+    }
+
+    // 两个修订之间的字段变化；所有页都相同时不展开场景，直接返回 0
+    size_t diff(size_t from, size_t to, vector<FieldChange>& out, const DiffOptions& options = {}) const;
+
+    // 所有修订与工作副本引用的不同页数，用于估计内存占用
+    [[nodiscard]] size_t uniquePageCount() const;
+
+private:
+    void moveTo(size_t id);
+
+    vector<Revision> revisions;
+    map<string, size_t> branch_heads;
+    string branch_name = "main";
+    size_t current = 0;
+    vector<size_t> redo_stack;
+    ScenarioSnapshot work;
+};
+}
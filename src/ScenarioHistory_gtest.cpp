@@ -0,0 +1,115 @@
+#include "ScenarioHistory.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+TEST(ScenarioHistory, CopyOnWrite)
+{
+    auto data_path = fs::current_path() / "tests";
+    const auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+    const auto& raw = image->getScenario(0);
+
+    ScenarioSnapshot base(raw);
+    auto copy = base;
+    EXPECT_EQ(copy.sharedPageCount(base), ScenarioSnapshot::PAGE_COUNT);
+
+    const auto& command = layout_field<Raw::Character>("command");
+    const auto value = copy.getField(BlockKind::Characters, 5, command);
+    EXPECT_EQ(value, raw.characters[5].command);
+    // 写入原值不复制页
+    copy.setField(BlockKind::Characters, 5, command, value);
+    EXPECT_EQ(copy.sharedPageCount(base), ScenarioSnapshot::PAGE_COUNT);
+
+    copy.setField(BlockKind::Characters, 5, command, value + 1);
+    EXPECT_EQ(copy.sharedPageCount(base), ScenarioSnapshot::PAGE_COUNT - 1);
+    EXPECT_EQ(base.getField(BlockKind::Characters, 5, command), value);
+    const auto page = (ScenarioSnapshot::recordOffset(BlockKind::Characters, 5) + command.offset)
+                    / ScenarioSnapshot::PAGE_SIZE;
+    EXPECT_EQ(copy.changedPages(base), std::vector<size_t>{page});
+
+    // 跨页的整条记录
+    auto character = copy.getRecord<Raw::Character>(100);
+    EXPECT_EQ(std::memcmp(&character, &raw.characters[100], sizeof(character)), 0);
+    character.politics ^= 1;
+    copy.setRecord(100, character);
+    auto out = std::make_unique<Raw::Scenario>();
+    copy.copyTo(*out);
+    EXPECT_EQ(out->characters[100].politics, raw.characters[100].politics ^ 1);
+    EXPECT_EQ(out->characters[5].command, value + 1);
+
+    EXPECT_THROW(copy.setField(BlockKind::Characters, 5, command, 256), std::out_of_range);
+    EXPECT_THROW(copy.setField(BlockKind::Characters, 5, layout_field<Raw::Character>("name"), 1),
+                 std::invalid_argument);
+    EXPECT_THROW((void)copy.getRecord<Raw::Character>(record_count(BlockKind::Characters)), std::out_of_range);
+    std::uint8_t byte;
+    EXPECT_THROW(copy.read(sizeof(Raw::Scenario), {&byte, 1}), std::out_of_range);
+}
+
+TEST(ScenarioHistory, UndoRedoBranches)
+{
+    auto data_path = fs::current_path() / "tests";
+    const auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+    const auto& raw = image->getScenario(0);
+    const auto& money = layout_field<Raw::Force>("money");
+
+    ScenarioHistory history(raw);
+    EXPECT_FALSE(history.isDirty());
+    EXPECT_FALSE(history.canUndo());
+    EXPECT_EQ(history.commit(), 0);
+    EXPECT_EQ(history.uniquePageCount(), ScenarioSnapshot::PAGE_COUNT);
+
+    history.working().setField(BlockKind::Forces, 2, money, 1000);
+    EXPECT_TRUE(history.isDirty());
+    EXPECT_EQ(history.commit("money"), 1);
+    history.working().setField(BlockKind::Forces, 2, money, 2000);
+    EXPECT_EQ(history.commit("more money"), 2);
+    // 每个修订只多出被修改的一页
+    EXPECT_EQ(history.uniquePageCount(), ScenarioSnapshot::PAGE_COUNT + 2);
+
+    std::vector<FieldChange> changes;
+    EXPECT_EQ(history.diff(0, 2, changes), 1);
+    ASSERT_EQ(changes.size(), 1);
+    EXPECT_EQ(changes[0].table, BlockKind::Forces);
+    EXPECT_EQ(changes[0].record, 2);
+    EXPECT_EQ(changes[0].after, 2000);
+    changes.clear();
+    EXPECT_EQ(history.diff(1, 1, changes), 0);
+
+    // 撤销会丢弃未提交的修改
+    history.working().setField(BlockKind::Forces, 3, money, 1);
+    EXPECT_TRUE(history.undo());
+    EXPECT_EQ(history.head(), 1);
+    EXPECT_FALSE(history.isDirty());
+    EXPECT_EQ(history.working().getField(BlockKind::Forces, 2, money), 1000);
+    EXPECT_TRUE(history.undo());
+    EXPECT_FALSE(history.undo());
+    EXPECT_TRUE(history.redo());
+    EXPECT_EQ(history.working().getField(BlockKind::Forces, 2, money), 1000);
+    EXPECT_TRUE(history.canRedo());
+
+    // 撤销后再提交放弃重做记录
+    history.working().setField(BlockKind::Forces, 2, money, 500);
+    EXPECT_EQ(history.commit(), 3);
+    EXPECT_FALSE(history.canRedo());
+    EXPECT_EQ(history.revision(3).parent, 1);
+    EXPECT_EQ(history.revision(2).label, "more money");
+
+    history.branch("experiment");
+    EXPECT_THROW(history.branch("main"), std::invalid_argument);
+    history.working().setField(BlockKind::Forces, 2, money, 9999);
+    EXPECT_EQ(history.commit(), 4);
+    history.checkout("main");
+    EXPECT_EQ(history.head(), 3);
+    EXPECT_EQ(history.working().getField(BlockKind::Forces, 2, money), 500);
+    history.checkout("experiment");
+    EXPECT_EQ(history.working().getField(BlockKind::Forces, 2, money), 9999);
+    EXPECT_EQ(history.currentBranch(), "experiment");
+    EXPECT_EQ(history.branches(), (std::vector<std::string>{"experiment", "main"}));
+    EXPECT_THROW(history.checkout("missing"), std::out_of_range);
+    EXPECT_THROW((void)history.revision(5), std::out_of_range);
+}
@@ -0,0 +1,329 @@
+#include "ScenarioStore.h"
+
+using namespace std;
+
+namespace DragonData
+{
+ScenarioStore::ScenarioStore(const Raw::Scenario& raw)
+{
+    // 先建立各表的槽位映射，再填充列，关联字段才能一次解析到位
+    for (size_t i = 0; i < MAX_CHARACTERS; ++i)
+    {
+        if (raw.characters[i].name.name[0] == 0) continue;
+        character_slots.set(i, static_cast<uint8_t>(characters.count++));
+    }
+
+    for (size_t i = 0; i < MAX_CITIES; ++i)
+    {
+        const auto& axis = raw.cities[i].axis;
+        if (axis.x == 0 || axis.y == 0) continue;
+        city_slots.set(i, static_cast<uint8_t>(cities.count++));
+    }
+
+    for (size_t i = 0; i < MAX_FORCES; ++i)
+    {
+        if (raw.forces[i].status == 0) continue;
+        force_slots.set(i, static_cast<uint8_t>(forces.count++));
+    }
+
+    for (size_t i = 0; i < MAX_CHARACTERS; ++i)
+    {
+        const auto n = character_slots[static_cast<uint8_t>(i)];
+        if (n == NO_INDEX) continue;
+        const auto& item = raw.characters[i];
+        characters.slot[n] = static_cast<uint8_t>(i);
+        characters.name[n] = item.name;
+        characters.alias[n] = item.alias;
+        characters.siege_ability[n] = item.siege_ability;
+        characters.field_ability[n] = item.field_ability;
+        characters.naval_ability[n] = item.naval_ability;
+        characters.battle_ability[n] = item.battle_ability;
+        characters.command[n] = item.command;
+        characters.politics[n] = item.politics;
+        characters.status[n] = item.status;
+        characters.month_to_board[n] = item.month_to_board;
+        characters.force_or_capture[n] = forceBySlot(item.force_or_capture);
+        characters.force_origin[n] = forceBySlot(item.force_origin);
+        characters.force_next[n] = forceBySlot(item.force_next);
+    }
+
+    for (size_t i = 0; i < MAX_CITIES; ++i)
+    {
+        const auto n = city_slots[static_cast<uint8_t>(i)];
+        if (n == NO_INDEX) continue;
+        const auto& item = raw.cities[i];
+        cities.slot[n] = static_cast<uint8_t>(i);
+        cities.name[n] = item.name;
+        cities.axis[n] = item.axis;
+        cities.max_productivity[n] = item.max_productivity;
+        cities.cur_productivity[n] = item.cur_productivity;
+        cities.soldiers[n] = item.soldiers;
+        cities.force[n] = forceBySlot(item.force);
+        cities.affairs_owner[n] = item.affairs_owner == 0 ? NO_INDEX : characterBySlot(item.affairs_owner);
+    }
+
+    for (size_t i = 0; i < MAX_FORCES; ++i)
+    {
+        const auto n = force_slots[static_cast<uint8_t>(i)];
+        if (n == NO_INDEX) continue;
+        const auto& item = raw.forces[i];
+        forces.slot[n] = static_cast<uint8_t>(i);
+        forces.status[n] = item.status;
+        forces.warlord[n] = characterBySlot(item.warlord);
+        forces.advisor[n] = item.advisor == 0x7f ? NO_INDEX : characterBySlot(item.advisor);
+        forces.capital[n] = cityBySlot(item.capital);
+        forces.money[n] = static_cast<int32_t>(
+            static_cast<uint32_t>(item.money[0]) |
+            static_cast<uint32_t>(item.money[1]) << 8 |
+            static_cast<uint32_t>(item.money[2]) << 16
+        );
+        forces.city_count[n] = item.city_count;
+    }
+
+    for (size_t i = 0; i < MAX_LEGIONS; ++i)
+    {
+        const auto& item = raw.legions[i];
+        if (item.current_axis.x == 0 || item.current_axis.y == 0) continue;
+        const auto n = legions.count++;
+        legions.slot[n] = static_cast<uint8_t>(i);
+        legions.force[n] = forceBySlot(item.force);
+        legions.leader[n] = characterBySlot(item.leader);
+        legions.target_city[n] = cityBySlot(item.target_city);
+        legions.total_soldier[n] = item.total_soldier;
+        legions.morale[n] = item.morale;
+        legions.current_axis[n] = item.current_axis;
+        legions.target_axis[n] = item.target_axis;
+    }
+
+    player_force = forceBySlot(raw.game_data.force);
+}
+
+array<uint32_t, MAX_FORCES> ScenarioStore::sumLegionSoldiersByForce() const
+{
+    array<uint32_t, MAX_FORCES> result{};
+    for (size_t i = 0; i < legions.count; ++i)
+    {
+        const auto f = legions.force[i];
+        if (f != NO_INDEX) result[f] += legions.total_soldier[i];
+    }
+    return result;
+}
+
+array<uint32_t, MAX_FORCES> ScenarioStore::sumCitySoldiersByForce() const
+{
+    array<uint32_t, MAX_FORCES> result{};
+    for (size_t i = 0; i < cities.count; ++i)
+    {
+        const auto f = cities.force[i];
+        if (f != NO_INDEX) result[f] += cities.soldiers[i];
+    }
+    return result;
+}
+
+array<uint32_t, MAX_FORCES> ScenarioStore::countCharactersByForce() const
+{
+    array<uint32_t, MAX_FORCES> result{};
+    for (size_t i = 0; i < characters.count; ++i)
+    {
+        const auto f = characters.force_or_capture[i];
+        if (f != NO_INDEX && characters.status[i] != static_cast<uint8_t>(CharacterStatus::DeadOrCaptured)) ++result[f];
+    }
+    return result;
+}
+
+uint8_t CharacterView::getSlot() const
+{
+    return store->getCharacters().slot[index];
+}
+
+const wstring& CharacterView::getName() const
+{
+    const auto& name = store->getCharacters().name[index].name;
+    return intern_name(name, std::size(name));
+}
+
+const wstring& CharacterView::getAlias() const
+{
+    const auto& alias = store->getCharacters().alias[index].name;
+    return intern_name(alias, std::size(alias));
+}
+
+uint8_t CharacterView::getSiegeAbility() const
+{
+    return store->getCharacters().siege_ability[index];
+}
+
+uint8_t CharacterView::getFieldAbility() const
+{
+    return store->getCharacters().field_ability[index];
+}
+
+uint8_t CharacterView::getNavalAbility() const
+{
+    return store->getCharacters().naval_ability[index];
+}
+
+uint8_t CharacterView::getBattleAbility() const
+{
+    return store->getCharacters().battle_ability[index];
+}
+
+uint8_t CharacterView::getCommand() const
+{
+    return store->getCharacters().command[index];
+}
+
+uint8_t CharacterView::getPolitics() const
+{
+    return store->getCharacters().politics[index];
+}
+
+CharacterStatus CharacterView::getStatus() const
+{
+    return CharacterStatusFromRaw(store->getCharacters().status[index]);
+}
+
+uint8_t CharacterView::getMonthToBoard() const
+{
+    return store->getCharacters().month_to_board[index];
+}
+
+uint8_t CharacterView::getForceCapture() const
+{
+    return store->getCharacters().force_or_capture[index];
+}
+
+uint8_t CharacterView::getForceOrigin() const
+{
+    return store->getCharacters().force_origin[index];
+}
+
+uint8_t CharacterView::getForceNext() const
+{
+    return store->getCharacters().force_next[index];
+}
+
+uint8_t CityView::getSlot() const
+{
+    return store->getCities().slot[index];
+}
+
+const wstring& CityView::getName() const
+{
+    const auto& name = store->getCities().name[index].name;
+    return intern_name(name, std::size(name));
+}
+
+Raw::Axis CityView::getAxis() const
+{
+    return store->getCities().axis[index];
+}
+
+uint16_t CityView::getMaxProductivity() const
+{
+    return store->getCities().max_productivity[index];
+}
+
+uint16_t CityView::getCurProductivity() const
+{
+    return store->getCities().cur_productivity[index];
+}
+
+uint8_t CityView::getSoldiers() const
+{
+    return store->getCities().soldiers[index];
+}
+
+uint8_t CityView::getForce() const
+{
+    return store->getCities().force[index];
+}
+
+uint8_t CityView::getAffairsOwner() const
+{
+    return store->getCities().affairs_owner[index];
+}
+
+uint8_t ForceView::getSlot() const
+{
+    return store->getForces().slot[index];
+}
+
+const wstring& ForceView::getName() const
+{
+    // 势力以君主命名
+    static const wstring empty;
+    const auto warlord = getWarlord();
+    return warlord == NO_INDEX ? empty : store->character(warlord).getName();
+}
+
+uint8_t ForceView::getStatus() const
+{
+    return store->getForces().status[index];
+}
+
+uint8_t ForceView::getWarlord() const
+{
+    return store->getForces().warlord[index];
+}
+
+uint8_t ForceView::getAdvisor() const
+{
+    return store->getForces().advisor[index];
+}
+
+uint8_t ForceView::getCapital() const
+{
+    return store->getForces().capital[index];
+}
+
+int32_t ForceView::getMoney() const
+{
+    return store->getForces().money[index];
+}
+
+uint8_t ForceView::getCityCount() const
+{
+    return store->getForces().city_count[index];
+}
+
+uint8_t LegionView::getSlot() const
+{
+    return store->getLegions().slot[index];
+}
+
+uint8_t LegionView::getForce() const
+{
+    return store->getLegions().force[index];
+}
+
+uint8_t LegionView::getLeader() const
+{
+    return store->getLegions().leader[index];
+}
+
+uint8_t LegionView::getTargetCity() const
+{
+    return store->getLegions().target_city[index];
+}
+
+uint16_t LegionView::getTotalSoldier() const
+{
+    return store->getLegions().total_soldier[index];
+}
+
+uint8_t LegionView::getMorale() const
+{
+    return store->getLegions().morale[index];
+}
+
+Raw::Axis LegionView::getCurrentAxis() const
+{
+    return store->getLegions().current_axis[index];
+}
+
+Raw::Axis LegionView::getTargetAxis() const
+{
+    return store->getLegions().target_axis[index];
+}
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include "DragonData.h"
+
+namespace DragonData
+{
+class ScenarioStore;
+
+// 以下视图类只保存 store 指针与紧凑下标，可随意按值传递
+class CharacterView
+{
+public:
+    CharacterView(const ScenarioStore& store, uint8_t index)
+        : store(&store)
+          , index(index)
+    {
+    }
+
+    [[nodiscard]] uint8_t getIndex() const
+    {
+        return index;
+    }
+
+    [[nodiscard]] uint8_t getSlot() const;
+    [[nodiscard]] const wstring& getName() const;
+    [[nodiscard]] const wstring& getAlias() const;
+    [[nodiscard]] uint8_t getSiegeAbility() const;
+    [[nodiscard]] uint8_t getFieldAbility() const;
+    [[nodiscard]] uint8_t getNavalAbility() const;
+    [[nodiscard]] uint8_t getBattleAbility() const;
+    [[nodiscard]] uint8_t getCommand() const;
+    [[nodiscard]] uint8_t getPolitics() const;
+    [[nodiscard]] CharacterStatus getStatus() const;
+    [[nodiscard]] uint8_t getMonthToBoard() const;
+    [[nodiscard]] uint8_t getForceCapture() const;
+    [[nodiscard]] uint8_t getForceOrigin() const;
+    [[nodiscard]] uint8_t getForceNext() const;
+
+private:
+    const ScenarioStore* store;
+    uint8_t index;
+};
+
+class CityView
+{
+public:
+    CityView(const ScenarioStore& store, uint8_t index)
+        : store(&store)
+          , index(index)
+    {
+    }
+
+    [[nodiscard]] uint8_t getIndex() const
+    {
+        return index;
+    }
+
+    [[nodiscard]] uint8_t getSlot() const;
+    [[nodiscard]] const wstring& getName() const;
+    [[nodiscard]] Raw::Axis getAxis() const;
+    [[nodiscard]] uint16_t getMaxProductivity() const;
+    [[nodiscard]] uint16_t getCurProductivity() const;
+    [[nodiscard]] uint8_t getSoldiers() const;
+    [[nodiscard]] uint8_t getForce() const;
+    [[nodiscard]] uint8_t getAffairsOwner() const;
+
+private:
+    const ScenarioStore* store;
+    uint8_t index;
+};
+
+class ForceView
+{
+public:
+    ForceView(const ScenarioStore& store, uint8_t index)
+        : store(&store)
+          , index(index)
+    {
+    }
+
+    [[nodiscard]] uint8_t getIndex() const
+    {
+        return index;
+    }
+
+    [[nodiscard]] uint8_t getSlot() const;
+    [[nodiscard]] const wstring& getName() const;
+    [[nodiscard]] uint8_t getStatus() const;
+    [[nodiscard]] uint8_t getWarlord() const;
+    [[nodiscard]] uint8_t getAdvisor() const;
+    [[nodiscard]] uint8_t getCapital() const;
+    [[nodiscard]] int32_t getMoney() const;
+    [[nodiscard]] uint8_t getCityCount() const;
+
+private:
+    const ScenarioStore* store;
+    uint8_t index;
+};
+
+class LegionView
+{
+public:
+    LegionView(const ScenarioStore& store, uint8_t index)
+        : store(&store)
+          , index(index)
+    {
+    }
+
+    [[nodiscard]] uint8_t getIndex() const
+    {
+        return index;
+    }
+
+    [[nodiscard]] uint8_t getSlot() const;
+    [[nodiscard]] uint8_t getForce() const;
+    [[nodiscard]] uint8_t getLeader() const;
+    [[nodiscard]] uint8_t getTargetCity() const;
+    [[nodiscard]] uint16_t getTotalSoldier() const;
+    [[nodiscard]] uint8_t getMorale() const;
+    [[nodiscard]] Raw::Axis getCurrentAxis() const;
+    [[nodiscard]] Raw::Axis getTargetAxis() const;
+
+private:
+    const ScenarioStore* store;
+    uint8_t index;
+};
+
+// 扁平的场景存储：每类实体按列连续存放，实体间的关联以紧凑下标（uint8_t）表示。
+// 所有列都是定长数组，整个对象没有任何堆分配，可直接按值复制。
+class ScenarioStore
+{
+public:
+    explicit ScenarioStore(const Raw::Scenario& raw);
+
+    struct CharacterColumns
+    {
+        size_t count = 0;
+        array<uint8_t, MAX_CHARACTERS> slot{};
+        array<Raw::Name, MAX_CHARACTERS> name{};
+        array<Raw::Name, MAX_CHARACTERS> alias{};
+        array<uint8_t, MAX_CHARACTERS> siege_ability{};
+        array<uint8_t, MAX_CHARACTERS> field_ability{};
+        array<uint8_t, MAX_CHARACTERS> naval_ability{};
+        array<uint8_t, MAX_CHARACTERS> battle_ability{};
+        array<uint8_t, MAX_CHARACTERS> command{};
+        array<uint8_t, MAX_CHARACTERS> politics{};
+        array<uint8_t, MAX_CHARACTERS> status{};
+        array<uint8_t, MAX_CHARACTERS> month_to_board{};
+        array<uint8_t, MAX_CHARACTERS> force_or_capture{};
+        array<uint8_t, MAX_CHARACTERS> force_origin{};
+        array<uint8_t, MAX_CHARACTERS> force_next{};
+    };
+
+    struct CityColumns
+    {
+        size_t count = 0;
+        array<uint8_t, MAX_CITIES> slot{};
+        array<Raw::Name, MAX_CITIES> name{};
+        array<Raw::Axis, MAX_CITIES> axis{};
+        array<uint16_t, MAX_CITIES> max_productivity{};
+        array<uint16_t, MAX_CITIES> cur_productivity{};
+        array<uint8_t, MAX_CITIES> soldiers{};
+        array<uint8_t, MAX_CITIES> force{};
+        array<uint8_t, MAX_CITIES> affairs_owner{};
+    };
+
+    struct ForceColumns
+    {
+        size_t count = 0;
+        array<uint8_t, MAX_FORCES> slot{};
+        array<uint8_t, MAX_FORCES> status{};
+        array<uint8_t, MAX_FORCES> warlord{};
+        array<uint8_t, MAX_FORCES> advisor{};
+        array<uint8_t, MAX_FORCES> capital{};
+        array<int32_t, MAX_FORCES> money{};
+        array<uint8_t, MAX_FORCES> city_count{};
+    };
+
+    struct LegionColumns
+    {
+        size_t count = 0;
+        array<uint8_t, MAX_LEGIONS> slot{};
+        array<uint8_t, MAX_LEGIONS> force{};
+        array<uint8_t, MAX_LEGIONS> leader{};
+        array<uint8_t, MAX_LEGIONS> target_city{};
+        array<uint16_t, MAX_LEGIONS> total_soldier{};
+        array<uint8_t, MAX_LEGIONS> morale{};
+        array<Raw::Axis, MAX_LEGIONS> current_axis{};
+        array<Raw::Axis, MAX_LEGIONS> target_axis{};
+    };
+
+    [[nodiscard]] const CharacterColumns& getCharacters() const
+    {
+        return characters;
+    }
+
+    [[nodiscard]] const CityColumns& getCities() const
+    {
+        return cities;
+    }
+
+    [[nodiscard]] const ForceColumns& getForces() const
+    {
+        return forces;
+    }
+
+    [[nodiscard]] const LegionColumns& getLegions() const
+    {
+        return legions;
+    }
+
+    [[nodiscard]] CharacterView character(const uint8_t index) const
+    {
+        return {*this, index};
+    }
+
+    [[nodiscard]] CityView city(const uint8_t index) const
+    {
+        return {*this, index};
+    }
+
+    [[nodiscard]] ForceView force(const uint8_t index) const
+    {
+        return {*this, index};
+    }
+
+    [[nodiscard]] LegionView legion(const uint8_t index) const
+    {
+        return {*this, index};
+    }
+
+    // 原始槽位到紧凑下标的映射，空槽位或超出范围时为 NO_INDEX
+    [[nodiscard]] uint8_t characterBySlot(const uint8_t slot) const
+    {
+        return character_slots[slot];
+    }
+
+    [[nodiscard]] uint8_t cityBySlot(const uint8_t slot) const
+    {
+        return city_slots[slot];
+    }
+
+    [[nodiscard]] uint8_t forceBySlot(const uint8_t slot) const
+    {
+        return force_slots[slot];
+    }
+
+    [[nodiscard]] uint8_t getPlayerForce() const
+    {
+        return player_force;
+    }
+
+    // 批量统计，结果按势力的紧凑下标排列
+    [[nodiscard]] array<uint32_t, MAX_FORCES> sumLegionSoldiersByForce() const;
+    [[nodiscard]] array<uint32_t, MAX_FORCES> sumCitySoldiersByForce() const;
+    [[nodiscard]] array<uint32_t, MAX_FORCES> countCharactersByForce() const;
+
+private:
+    CharacterColumns characters;
+    CityColumns cities;
+    ForceColumns forces;
+    LegionColumns legions;
+    SlotMap character_slots;
+    SlotMap city_slots;
+    SlotMap force_slots;
+    uint8_t player_force;
+};
+}
@@ -0,0 +1,61 @@
+#include "ScenarioStore.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(ScenarioStore, MatchesObjectModel)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+
+    const Raw::Scenario& raw = image->getScenario(0);
+    ScenarioStore store(raw);
+    Scenario scenario(raw);
+
+    ASSERT_EQ(store.getCharacters().count, scenario.getCharacters().size());
+    ASSERT_EQ(store.getForces().count, scenario.getForces().size());
+    ASSERT_EQ(store.getLegions().count, scenario.getLegions().size());
+
+    for (uint8_t i = 0; i < store.getCharacters().count; ++i)
+    {
+        const auto view = store.character(i);
+        const auto& item = scenario.getCharacters()[i];
+        EXPECT_EQ(view.getSlot(), item->getIndex());
+        EXPECT_EQ(view.getName(), item->getName());
+        EXPECT_EQ(view.getCommand(), item->getCommand());
+        EXPECT_EQ(store.characterBySlot(view.getSlot()), i);
+    }
+
+    for (uint8_t i = 0; i < store.getForces().count; ++i)
+    {
+        EXPECT_EQ(store.force(i).getMoney(), scenario.getForces()[i]->getMoney());
+    }
+}
+
+TEST(ScenarioStore, SumSoldiersByForce)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SAVE.DAT");
+    ASSERT_TRUE(image);
+
+    const Raw::Scenario& raw = image->getScenario(0);
+    ScenarioStore store(raw);
+
+    uint32_t expected = 0;
+    for (const auto& legion : raw.legions)
+    {
+        if (legion.current_axis.x == 0 || legion.current_axis.y == 0) continue;
+        if (store.forceBySlot(legion.force) != NO_INDEX) expected += legion.total_soldier;
+    }
+
+    uint32_t total = 0;
+    for (const auto soldiers : store.sumLegionSoldiersByForce())
+    {
+        total += soldiers;
+    }
+    EXPECT_EQ(total, expected);
+}
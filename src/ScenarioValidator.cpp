@@ -0,0 +1,288 @@
+#include "ScenarioValidator.h"
+
+#include <type_traits>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    constexpr int FORCE_COUNT = extent_v<decltype(Raw::Scenario::forces)>;
+    constexpr int NONE = -1;
+
+    // 关联字段的分类结果
+    enum : uint8_t
+    {
+        REF_OK = 0,
+        REF_DANGLING = 1,
+        REF_OUT_OF_RANGE = 2,
+    };
+
+    using ReferenceTable = array<uint8_t, 256>;
+
+    struct ReferenceCheck
+    {
+        BlockKind table;
+        const FieldInfo* field;
+        BlockKind target;
+        // 表示“无”的取值，与各构造函数及 resolve 中的判断一致
+        int none[2];
+    };
+
+    template <typename R>
+    constexpr ReferenceCheck reference(const char* field, const BlockKind target, const int none_1 = NONE,
+                                       const int none_2 = NONE)
+    {
+        return {RecordLayout<R>::kind, &layout_field<R>(field), target, {none_1, none_2}};
+    }
+
+    constexpr ReferenceCheck REFERENCE_CHECKS[] = {
+        reference<Raw::GameData>("force", BlockKind::Forces, FORCE_COUNT, 0xff),
+        reference<Raw::Force>("warlord", BlockKind::Characters),
+        reference<Raw::Force>("advisor", BlockKind::Characters, 0x7f, 0xff),
+        reference<Raw::Force>("capital", BlockKind::Cities, 0xff),
+        reference<Raw::Force>("diplomacy_owner", BlockKind::Characters, 0, 0xff),
+        reference<Raw::City>("force", BlockKind::Forces, FORCE_COUNT, 0xff),
+        reference<Raw::City>("affairs_owner", BlockKind::Characters, 0, 0xff),
+        reference<Raw::Legion>("force", BlockKind::Forces),
+        reference<Raw::Legion>("leader", BlockKind::Characters),
+        reference<Raw::Legion>("target_city", BlockKind::Cities),
+        reference<Raw::Character>("force_next", BlockKind::Forces, FORCE_COUNT, 0xff),
+        reference<Raw::Character>("force_or_capture", BlockKind::Forces, FORCE_COUNT, 0xff),
+        reference<Raw::Character>("force_origin", BlockKind::Forces, FORCE_COUNT, 0xff),
+    };
+
+    // 目标表中每个取值的分类：有效槽位、空槽位或超出范围
+    ReferenceTable classify_targets(const Raw::Scenario& raw, const BlockKind kind)
+    {
+        ReferenceTable table;
+        table.fill(REF_OUT_OF_RANGE);
+        const auto block = block_span(raw, kind);
+        const auto size = record_size(kind);
+        for (size_t i = 0; i < record_count(kind); ++i)
+        {
+            table[i] = is_record_occupied(kind, block.data + i * size) ? REF_OK : REF_DANGLING;
+        }
+        return table;
+    }
+
+    struct Collector
+    {
+        vector<ValidationIssue>& out;
+        const ValidationOptions& options;
+        uint8_t scenario;
+        size_t count = 0;
+
+        // 返回 false 时停止检查
+        bool report(const IssueKind kind, const IssueSeverity severity, const BlockKind table, const size_t record,
+                    const FieldInfo& field, const int64_t value)
+        {
+            if (severity == IssueSeverity::Warning && !options.include_warnings) return true;
+            out.push_back({kind, severity, table, scenario, static_cast<uint8_t>(record), &field, value});
+            ++count;
+            return true;
+        }
+    };
+
+    struct ErrorProbe
+    {
+        bool found = false;
+
+        bool report(IssueKind, const IssueSeverity severity, BlockKind, size_t, const FieldInfo&, int64_t)
+        {
+            if (severity != IssueSeverity::Error) return true;
+            found = true;
+            return false;
+        }
+    };
+
+    template <typename Sink>
+    bool check_references(const Raw::Scenario& raw, Sink& sink)
+    {
+        const ReferenceTable characters = classify_targets(raw, BlockKind::Characters);
+        const ReferenceTable cities = classify_targets(raw, BlockKind::Cities);
+        const ReferenceTable forces = classify_targets(raw, BlockKind::Forces);
+
+        for (const auto& check : REFERENCE_CHECKS)
+        {
+            auto table = check.target == BlockKind::Characters ? characters
+                : check.target == BlockKind::Cities ? cities
+                : forces;
+            for (const auto none : check.none)
+            {
+                if (none != NONE) table[none] = REF_OK;
+            }
+
+            // 每条记录只有一次查表；出现问题的记录很少，报告分支几乎不会进入
+            const auto& field = *check.field;
+            const auto block = block_span(raw, check.table);
+            const auto size = record_size(check.table);
+            for (size_t i = 0; i < record_count(check.table); ++i)
+            {
+                const auto* record = block.data + i * size;
+                const auto value = record[field.offset];
+                const auto result = table[value];
+                if (result == REF_OK || !is_record_occupied(check.table, record)) continue;
+
+                const bool go_on = result == REF_DANGLING
+                    ? sink.report(IssueKind::DanglingReference, IssueSeverity::Warning, check.table, i, field, value)
+                    : sink.report(IssueKind::IndexOutOfRange, IssueSeverity::Error, check.table, i, field, value);
+                if (!go_on) return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Sink>
+    bool check_axis(const Raw::Axis& axis, const BlockKind table, const size_t record, const FieldInfo& x,
+                    const FieldInfo& y, const ValidationOptions& options, Sink& sink)
+    {
+        if (axis.x > options.map_width &&
+            !sink.report(IssueKind::CoordinateOutOfRange, IssueSeverity::Error, table, record, x, axis.x))
+        {
+            return false;
+        }
+        if (axis.y > options.map_height &&
+            !sink.report(IssueKind::CoordinateOutOfRange, IssueSeverity::Error, table, record, y, axis.y))
+        {
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Sink>
+    bool check_values(const Raw::Scenario& raw, const ValidationOptions& options, Sink& sink)
+    {
+        constexpr auto& total_forces = layout_field<Raw::GameData>("total_forces");
+        constexpr auto& city_x = layout_field<Raw::City>("axis.x");
+        constexpr auto& city_y = layout_field<Raw::City>("axis.y");
+        constexpr auto& target_x = layout_field<Raw::Legion>("target_axis.x");
+        constexpr auto& target_y = layout_field<Raw::Legion>("target_axis.y");
+        constexpr auto& status = layout_field<Raw::Character>("status");
+
+        if (raw.game_data.total_forces > FORCE_COUNT &&
+            !sink.report(IssueKind::InvalidValue, IssueSeverity::Warning, BlockKind::GameData, 0, total_forces,
+                         raw.game_data.total_forces))
+        {
+            return false;
+        }
+
+        // 坐标为 0 的城市视为空槽位，只需检查上限
+        for (size_t i = 0; i < size(raw.cities); ++i)
+        {
+            const auto& axis = raw.cities[i].axis;
+            if (axis.x == 0 || axis.y == 0) continue;
+            if (!check_axis(axis, BlockKind::Cities, i, city_x, city_y, options, sink)) return false;
+        }
+
+        for (size_t i = 0; i < size(raw.legions); ++i)
+        {
+            const auto& item = raw.legions[i];
+            if (item.current_axis.x == 0 || item.current_axis.y == 0) continue;
+            if (!check_axis(item.target_axis, BlockKind::Legions, i, target_x, target_y, options, sink)) return false;
+        }
+
+        for (size_t i = 0; i < size(raw.characters); ++i)
+        {
+            const auto& item = raw.characters[i];
+            if (item.name.name[0] == 0 || item.status <= static_cast<uint8_t>(CharacterStatus::DeadOrCaptured)) continue;
+            if (!sink.report(IssueKind::InvalidValue, IssueSeverity::Warning, BlockKind::Characters, i, status,
+                             item.status))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const wchar_t* table_name(const BlockKind kind)
+    {
+        switch (kind)
+        {
+        case BlockKind::GameData:
+            return L"GameData";
+        case BlockKind::Forces:
+            return L"Forces";
+        case BlockKind::Friendship:
+            return L"Friendship";
+        case BlockKind::Cities:
+            return L"Cities";
+        case BlockKind::Legions:
+            return L"Legions";
+        case BlockKind::Characters:
+            return L"Characters";
+        default:
+            return L"Scenario";
+        }
+    }
+
+    const wchar_t* issue_name(const IssueKind kind)
+    {
+        switch (kind)
+        {
+        case IssueKind::IndexOutOfRange:
+            return L"index out of range";
+        case IssueKind::DanglingReference:
+            return L"reference to empty slot";
+        case IssueKind::CoordinateOutOfRange:
+            return L"coordinate out of range";
+        case IssueKind::InvalidValue:
+            return L"invalid value";
+        }
+        return L"unknown issue";
+    }
+}
+
+size_t validate_scenario(const Raw::Scenario& raw, vector<ValidationIssue>& out, const ValidationOptions& options,
+                         const uint8_t scenario)
+{
+    Collector sink{out, options, scenario};
+    check_references(raw, sink);
+    check_values(raw, options, sink);
+    return sink.count;
+}
+
+size_t validate_file(const Raw::File& file, vector<ValidationIssue>& out, const ValidationOptions& options)
+{
+    size_t count = 0;
+    for (uint8_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+    {
+        count += validate_scenario(file.scenarios[i], out, options, i);
+    }
+    return count;
+}
+
+bool is_valid_scenario(const Raw::Scenario& raw, const ValidationOptions& options)
+{
+    ErrorProbe sink;
+    return check_references(raw, sink) && check_values(raw, options, sink);
+}
+
+bool is_valid_file(const Raw::File& file, const ValidationOptions& options)
+{
+    for (const auto& scenario : file.scenarios)
+    {
+        if (!is_valid_scenario(scenario, options)) return false;
+    }
+    return true;
+}
+
+wstring issue_text(const ValidationIssue& issue)
+{
+    wstring text = table_name(issue.table);
+    if (issue.table != BlockKind::GameData)
+    {
+        text += L"[" + to_wstring(issue.record) + L"]";
+    }
+    text += L".";
+    for (const char* p = issue.field->name; *p != '\0'; ++p)
+    {
+        text += static_cast<wchar_t>(*p);
+    }
+    text += L": ";
+    text += issue_name(issue.kind);
+    text += L" (" + to_wstring(issue.value) + L")";
+    return text;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "ScenarioDiff.h"
+
+namespace DragonData
+{
+enum class IssueSeverity : uint8_t
+{
+    Warning = 0, // 游戏本身也会产生的数据，例如指向已灭亡势力的关联
+    Error = 1,   // 文件已损坏，按此构建对象会越界
+};
+
+enum class IssueKind : uint8_t
+{
+    IndexOutOfRange = 0,      // 关联超出目标表的范围，且不是表示“无”的值（错误）
+    DanglingReference = 1,    // 关联指向空槽位（警告）
+    CoordinateOutOfRange = 2, // 坐标超出地图范围（错误）
+    InvalidValue = 3,         // 枚举或计数超出已知范围（警告）
+};
+
+struct ValidationIssue
+{
+    IssueKind kind;
+    IssueSeverity severity;
+    BlockKind table;
+    uint8_t scenario;
+    uint8_t record; // 原始槽位
+    const FieldInfo* field;
+    int64_t value;
+};
+
+struct ValidationOptions
+{
+    // 所有剧本的城市都在 370 × 248 以内。军团当前位置的编码方式尚不清楚，不做检查
+    uint16_t map_width = 512;
+    uint16_t map_height = 512;
+    bool include_warnings = true;
+};
+
+// 在构建任何对象之前检查场景中的关联字节、坐标与枚举值，把发现的问题追加到 out，返回追加的个数。
+// 空槽位中的记录不检查。每个关联字段通过 256 项的查找表一次分类，整个场景只做一遍线性扫描。
+size_t validate_scenario(const Raw::Scenario& raw, vector<ValidationIssue>& out,
+                         const ValidationOptions& options = {}, uint8_t scenario = 0);
+
+size_t validate_file(const Raw::File& file, vector<ValidationIssue>& out, const ValidationOptions& options = {});
+
+// 只判断是否存在错误，不分配内存，遇到第一个错误即返回
+[[nodiscard]] bool is_valid_scenario(const Raw::Scenario& raw, const ValidationOptions& options = {});
+[[nodiscard]] bool is_valid_file(const Raw::File& file, const ValidationOptions& options = {});
+
+// 例如 L"Forces[3].warlord: index out of range (200)"
+wstring issue_text(const ValidationIssue& issue);
+}
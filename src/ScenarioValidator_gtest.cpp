@@ -0,0 +1,96 @@
+#include "ScenarioValidator.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(ScenarioValidator, FixturesHaveNoErrors)
+{
+    auto data_path = fs::current_path() / "tests";
+    for (const auto* name : {"SINARIO-01.DAT", "SINARIO-02.DAT", "SINARIO-03.DAT", "SINARIO-04.DAT",
+                             "SINARIO-05.DAT", "SINARIO-06.DAT", "SAVE.DAT"})
+    {
+        auto image = RawFileImage::open(data_path / name);
+        ASSERT_TRUE(image);
+        EXPECT_TRUE(is_valid_file(image->getFile())) << name;
+
+        std::vector<ValidationIssue> issues;
+        validate_file(image->getFile(), issues);
+        for (const auto& issue : issues)
+        {
+            EXPECT_EQ(issue.severity, IssueSeverity::Warning) << name << ": " << testing::PrintToString(
+                issue_text(issue));
+        }
+    }
+
+    // 存档中的军团可能属于已灭亡的势力
+    auto image = RawFileImage::open(data_path / "SAVE.DAT");
+    std::vector<ValidationIssue> issues;
+    validate_scenario(image->getScenario(2), issues, {}, 2);
+    EXPECT_TRUE(std::any_of(issues.begin(), issues.end(), [](const ValidationIssue& issue)
+    {
+        return issue.kind == IssueKind::DanglingReference && issue.table == BlockKind::Legions &&
+            std::string(issue.field->name) == "force" && issue.scenario == 2;
+    }));
+    // 资金与其他库一致按无符号 24 位处理，最高位为 1 也不报告
+    EXPECT_TRUE(std::none_of(issues.begin(), issues.end(), [](const ValidationIssue& issue)
+    {
+        return issue.table == BlockKind::Forces && std::string(issue.field->name) == "money";
+    }));
+
+    issues.clear();
+    ValidationOptions options;
+    options.include_warnings = false;
+    EXPECT_EQ(validate_scenario(image->getScenario(2), issues, options), 0);
+}
+
+TEST(ScenarioValidator, ReportCorruptedRecords)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto image = RawFileImage::open(data_path / "SINARIO-01.DAT");
+    ASSERT_TRUE(image);
+    auto raw = std::make_unique<Raw::Scenario>(image->getScenario(0));
+
+    const auto force = static_cast<uint8_t>(std::find_if(std::begin(raw->forces), std::end(raw->forces),
+                                                         [](const Raw::Force& f) { return f.status != 0; }) -
+        std::begin(raw->forces));
+    raw->forces[force].warlord = 200;
+    raw->cities[5].axis.x = 4000;
+    EXPECT_FALSE(is_valid_scenario(*raw));
+
+    std::vector<ValidationIssue> issues;
+    ValidationOptions options;
+    options.include_warnings = false;
+    EXPECT_EQ(validate_scenario(*raw, issues, options, 1), 2);
+    ASSERT_EQ(issues.size(), 2);
+
+    EXPECT_EQ(issues[0].kind, IssueKind::IndexOutOfRange);
+    EXPECT_EQ(issues[0].severity, IssueSeverity::Error);
+    EXPECT_EQ(issues[0].table, BlockKind::Forces);
+    EXPECT_EQ(issues[0].record, force);
+    EXPECT_EQ(issues[0].scenario, 1);
+    EXPECT_EQ(issues[0].value, 200);
+    EXPECT_EQ(issue_text(issues[0]), L"Forces[" + std::to_wstring(force) + L"].warlord: index out of range (200)");
+
+    EXPECT_EQ(issues[1].kind, IssueKind::CoordinateOutOfRange);
+    EXPECT_EQ(issues[1].table, BlockKind::Cities);
+    EXPECT_EQ(issues[1].record, 5);
+    EXPECT_EQ(std::string(issues[1].field->name), "axis.x");
+
+    // 已损坏的文件在构建对象之前被拒绝
+    auto file_data = std::make_unique<Raw::File>(image->getFile());
+    file_data->scenarios[3] = *raw;
+    auto tmp_path = fs::temp_directory_path() / "ScenarioValidator_corrupted.DAT";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(file_data.get()), sizeof(Raw::File));
+    }
+    ScenarioFile file;
+    EXPECT_FALSE(file.loadFile(tmp_path));
+    EXPECT_TRUE(file.getScenarios().empty());
+    fs::remove(tmp_path);
+}
@@ -0,0 +1,249 @@
+#include "ScenarioWriter.h"
+#include "RawFileImage.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    // 名字未改变时保留原始字节（包括全角空格等填充），否则重新编码
+    template <size_t N>
+    void write_name(const wstring& name, char (&raw)[N])
+    {
+        if (intern_name(raw, N) == name) return;
+        Big5Table::instance().encode(name, raw, N);
+    }
+
+    template <typename Items, typename R>
+    size_t write_table(const Items& items, R* raw, const size_t capacity, const bool dirty_only)
+    {
+        size_t count = 0;
+        for (const auto& item : items)
+        {
+            if (dirty_only && !item->isDirty()) continue;
+            if (item->getIndex() >= capacity) throw out_of_range("entity slot out of range");
+            ScenarioWriter::write(*item, raw[item->getIndex()]);
+            ++count;
+        }
+        return count;
+    }
+
+    template <typename T>
+    void clear_dirty(const vector<shared_ptr<T>>& items)
+    {
+        for (const auto& item : items)
+        {
+            item->clearDirty();
+        }
+    }
+
+    template <typename T, typename R>
+    void flush_dirty(const WritableFileImage& target, const vector<shared_ptr<T>>& items, const R* raw)
+    {
+        for (const auto& item : items)
+        {
+            if (!item->isDirty()) continue;
+            const auto* record = reinterpret_cast<const uint8_t*>(&raw[item->getIndex()]);
+            target.flush(record - target.getData(), sizeof(R));
+        }
+    }
+
+    template <typename Items, typename R>
+    void collect_dirty(const Items& items, R* raw, const uint8_t* base, ChangeSet& changes)
+    {
+        for (const auto& item : items)
+        {
+            if (!item->isDirty()) continue;
+            auto& record = raw[item->getIndex()];
+            ScenarioWriter::write(*item, record);
+            changes.add(reinterpret_cast<const uint8_t*>(&record) - base, sizeof(R));
+        }
+    }
+}
+
+void ScenarioWriter::write(const Character& item, Raw::Character& raw)
+{
+    write_name(item.getName(), raw.name.name);
+    write_name(item.getAlias(), raw.alias.name);
+    writeNumbers(item, raw);
+}
+
+void ScenarioWriter::writeNumbers(const Character& item, Raw::Character& raw)
+{
+    raw.siege_ability = item.getSiegeAbility();
+    raw.field_ability = item.getFieldAbility();
+    raw.naval_ability = item.getNavalAbility();
+    raw.battle_ability = item.getBattleAbility();
+    raw.command = item.getCommand();
+    raw.politics = item.getPolitics();
+    // 未知的状态值读入时被当作 Idle，状态未改变时保留原值
+    if (CharacterStatusFromRaw(raw.status) != item.getStatus())
+    {
+        raw.status = static_cast<uint8_t>(item.getStatus());
+    }
+    raw.month_to_board = item.getMonthToBoard();
+}
+
+void ScenarioWriter::write(const City& item, Raw::City& raw)
+{
+    write_name(item.getName(), raw.name.name);
+    writeNumbers(item, raw);
+}
+
+void ScenarioWriter::writeNumbers(const City& item, Raw::City& raw)
+{
+    raw.max_productivity = item.getMaxProductivity();
+    raw.cur_productivity = item.getCurProductivity();
+    raw.increase = item.getIncrease();
+    raw.anti_disaster = item.getAntiDisaster();
+    raw.soldiers = item.getSoldiers();
+}
+
+void ScenarioWriter::write(const Force& item, Raw::Force& raw)
+{
+    writeNumbers(item, raw);
+}
+
+void ScenarioWriter::writeNumbers(const Force& item, Raw::Force& raw)
+{
+    raw.cavalries = item.getCavalries();
+    raw.infantries = item.getInfantries();
+    raw.archers = item.getArchers();
+    const auto money = static_cast<uint32_t>(item.getMoney());
+    raw.money[0] = static_cast<uint8_t>(money);
+    raw.money[1] = static_cast<uint8_t>(money >> 8);
+    raw.money[2] = static_cast<uint8_t>(money >> 16);
+}
+
+void ScenarioWriter::write(const Legion& item, Raw::Legion& raw)
+{
+    writeNumbers(item, raw);
+}
+
+void ScenarioWriter::writeNumbers(const Legion& item, Raw::Legion& raw)
+{
+    raw.total_soldier = item.getTotalSoldier();
+    raw.morale = item.getMorale();
+    raw.current_axis = item.getCurrentAxis();
+    raw.target_axis = item.getTargetAxis();
+}
+
+void ScenarioWriter::write(const GameData& item, Raw::GameData& raw)
+{
+    writeNumbers(item, raw);
+    write_name(item.getName(), raw.name);
+}
+
+void ScenarioWriter::writeNumbers(const GameData& item, Raw::GameData& raw)
+{
+    raw.day = item.getDay();
+    raw.month = item.getMonth();
+    raw.year = item.getYear();
+    raw.trust = item.getTrust();
+    raw.cur_tax_rate = item.getCurTaxRate();
+    raw.next_tax_rate = item.getNextTaxRate();
+}
+
+size_t ScenarioWriter::write(const Scenario& scenario, Raw::Scenario& raw, const bool dirty_only)
+{
+    size_t count = 0;
+    if (!dirty_only || scenario.getGameData().isDirty())
+    {
+        write(scenario.getGameData(), raw.game_data);
+        ++count;
+    }
+    count += write_table(scenario.getCharacters(), raw.characters, std::size(raw.characters), dirty_only);
+    count += write_table(scenario.getCities(), raw.cities, std::size(raw.cities), dirty_only);
+    count += write_table(scenario.getForces(), raw.forces, std::size(raw.forces), dirty_only);
+    count += write_table(scenario.getLegions(), raw.legions, std::size(raw.legions), dirty_only);
+    return count;
+}
+
+ChangeSet ScenarioWriter::collectChanges(const ScenarioFile& file, Raw::File& image)
+{
+    ChangeSet changes;
+    const auto* base = reinterpret_cast<const uint8_t*>(&image);
+    const auto& scenarios = file.getScenarios();
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        // 共享的场景只能读取，修改都在 edit 分离出的独占场景上
+        if (!scenarios.isMaterialized(i) || scenarios.isShared(i)) continue;
+        const auto& scenario = scenarios[i];
+        auto& raw = image.scenarios[i];
+
+        if (scenario.getGameData().isDirty())
+        {
+            write(scenario.getGameData(), raw.game_data);
+            changes.add(reinterpret_cast<const uint8_t*>(&raw.game_data) - base, sizeof(raw.game_data));
+        }
+        collect_dirty(scenario.getCharacters(), raw.characters, base, changes);
+        collect_dirty(scenario.getCities(), raw.cities, base, changes);
+        collect_dirty(scenario.getForces(), raw.forces, base, changes);
+        collect_dirty(scenario.getLegions(), raw.legions, base, changes);
+    }
+    return changes;
+}
+
+void ScenarioWriter::clearDirty(ScenarioFile& file)
+{
+    auto& scenarios = file.getScenarios();
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        if (!scenarios.isMaterialized(i) || scenarios.isShared(i)) continue;
+        auto& scenario = scenarios.edit(i);
+        scenario.getGameData().clearDirty();
+        clear_dirty(scenario.getCharacters());
+        clear_dirty(scenario.getCities());
+        clear_dirty(scenario.getForces());
+        clear_dirty(scenario.getLegions());
+    }
+}
+
+size_t ScenarioWriter::patchFile(ScenarioFile& file)
+{
+    const auto target = WritableFileImage::open(file.getPath());
+    if (!target) throw runtime_error("unexpected scenario file size: " + file.getPath().string());
+
+    size_t count = 0;
+    auto& scenarios = file.getScenarios();
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        if (!scenarios.isMaterialized(i) || scenarios.isShared(i)) continue;
+        auto& scenario = scenarios.edit(i);
+        auto& raw = target->getScenario(i);
+
+        const auto written = write(scenario, raw, true);
+        if (written == 0) continue;
+        count += written;
+
+        if (scenario.getGameData().isDirty())
+        {
+            target->flush(reinterpret_cast<const uint8_t*>(&raw.game_data) - target->getData(), sizeof(raw.game_data));
+        }
+        flush_dirty(*target, scenario.getCharacters(), raw.characters);
+        flush_dirty(*target, scenario.getCities(), raw.cities);
+        flush_dirty(*target, scenario.getForces(), raw.forces);
+        flush_dirty(*target, scenario.getLegions(), raw.legions);
+    }
+    clearDirty(file);
+    return count;
+}
+
+ChangeSet ScenarioWriter::saveFile(ScenarioFile& file, const fs::path& target, const bool sync)
+{
+    auto image = make_unique<Raw::File>(file.getImage()->getFile());
+    auto changes = collectChanges(file, *image);
+    // 写出加载时的文件长度；补齐的保留字节不属于文件
+    const auto size = file.getImage()->getFileSize();
+    if (!changes.empty() && changes.getRanges().back().offset + changes.getRanges().back().length > size)
+    {
+        throw runtime_error("change outside of scenario file: " + target.string());
+    }
+    replace_file_atomically(target, span(reinterpret_cast<const uint8_t*>(image.get()), size), sync);
+    clearDirty(file);
+    return changes;
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "DragonData.h"
+#include "RawFileImage.h"
+
+namespace DragonData
+{
+// 把实体的可编辑字段写回 Raw 记录。只覆盖模型提供 setter 的字段，
+// 保留字节以及模型不解析的字段保持原样，因此未修改的实体写回后与原始数据逐字节一致。
+class ScenarioWriter
+{
+public:
+    static void write(const Character& item, Raw::Character& raw);
+    static void write(const City& item, Raw::City& raw);
+    static void write(const Force& item, Raw::Force& raw);
+    static void write(const Legion& item, Raw::Legion& raw);
+    static void write(const GameData& item, Raw::GameData& raw);
+
+    // 只写回可编辑的数值字段，名字保持原样；不需要名字字节时（例如导出）避免重新编码
+    static void writeNumbers(const Character& item, Raw::Character& raw);
+    static void writeNumbers(const City& item, Raw::City& raw);
+    static void writeNumbers(const Force& item, Raw::Force& raw);
+    static void writeNumbers(const Legion& item, Raw::Legion& raw);
+    static void writeNumbers(const GameData& item, Raw::GameData& raw);
+
+    // 把场景写入 raw，dirty_only 为 true 时只写修改过的记录；返回写入的记录数
+    static size_t write(const Scenario& scenario, Raw::Scenario& raw, bool dirty_only = true);
+
+    // 把文件中修改过的记录写入 image（通常是文件映像的副本），返回这些记录在文件中的字节范围。
+    // 未构建的场景不会被访问，修改标记保持不变。
+    static ChangeSet collectChanges(const ScenarioFile& file, Raw::File& image);
+
+    static void clearDirty(ScenarioFile& file);
+
+    // 在文件上直接修补修改过的记录（共享可写映射），写入后清除修改标记。
+    // 返回写入的记录数。打开失败时抛出 std::runtime_error。
+    static size_t patchFile(ScenarioFile& file);
+
+    // 把修改保存到 target：把加载时的映像加上修改整体写入同目录的临时文件，
+    // 再原子地重命名覆盖 target。sync 为 false 时跳过 fsync，适合频繁的编辑-测试循环。
+    // 成功后清除修改标记并返回写入的字节范围；失败时抛出 std::runtime_error，target 保持不变。
+    static ChangeSet saveFile(ScenarioFile& file, const fs::path& target, bool sync = true);
+
+    static ChangeSet saveFile(ScenarioFile& file, const bool sync = true)
+    {
+        return saveFile(file, file.getPath(), sync);
+    }
+};
+}
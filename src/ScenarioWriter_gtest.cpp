@@ -0,0 +1,147 @@
+#include "ScenarioWriter.h"
+#include "RawFileImage.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(ScenarioWriter, RoundTripUnchanged)
+{
+    auto data_path = fs::current_path() / "tests";
+    for (const auto* name : {"SINARIO-01.DAT", "SINARIO-03.DAT", "SAVE.DAT"})
+    {
+        auto image = RawFileImage::open(data_path / name);
+        ASSERT_TRUE(image);
+        for (size_t i = 0; i < Raw::SCENARIO_COUNT; ++i)
+        {
+            const auto& raw = image->getScenario(i);
+            Scenario scenario(raw);
+            auto copy = std::make_unique<Raw::Scenario>(raw);
+            EXPECT_EQ(ScenarioWriter::write(scenario, *copy, false),
+                      1 + scenario.getCharacters().size() + scenario.getCities().size() +
+                      scenario.getForces().size() + scenario.getLegions().size());
+            EXPECT_EQ(std::memcmp(copy.get(), &raw, sizeof(raw)), 0) << name << " scenario " << i;
+        }
+    }
+}
+
+TEST(ScenarioWriter, PatchDirtyRecordsInPlace)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto tmp_path = fs::temp_directory_path() / "ScenarioWriter_SAVE.DAT";
+    fs::copy_file(data_path / "SAVE.DAT", tmp_path, fs::copy_options::overwrite_existing);
+
+    const auto original = RawFileImage::open(data_path / "SAVE.DAT");
+    ASSERT_TRUE(original);
+
+    {
+        ScenarioFile file(LoadMode::Lazy);
+        ASSERT_TRUE(file.loadFile(tmp_path));
+        auto& scenario = file.getScenarios().edit(1);
+        auto& character = *scenario.getCharacters()[3];
+        auto& city = *scenario.getCities()[5];
+        auto& force = *scenario.getForces()[0];
+
+        character.setCommand(99);
+        city.setName(L"龍城");
+        force.setMoney(50000);
+        scenario.getGameData().setDate(200, 3, 1);
+        EXPECT_THROW(city.setName(L"太長的城市名字"), std::invalid_argument);
+        EXPECT_THROW(force.setMoney(0x1000000), std::out_of_range);
+
+        EXPECT_EQ(ScenarioWriter::patchFile(file), 4);
+        EXPECT_FALSE(character.isDirty());
+        EXPECT_EQ(ScenarioWriter::patchFile(file), 0);
+    }
+
+    const auto patched = RawFileImage::open(tmp_path);
+    ASSERT_TRUE(patched);
+    const auto& before = original->getScenario(1);
+    const auto& after = patched->getScenario(1);
+    EXPECT_EQ(after.characters[3].command, 99);
+    EXPECT_EQ(intern_name(after.cities[5].name.name, 6), L"龍城");
+    EXPECT_EQ(after.game_data.year, 200);
+    EXPECT_EQ(after.forces[0].money[0] | after.forces[0].money[1] << 8 | after.forces[0].money[2] << 16, 50000);
+
+    // 只有被修改的字段发生变化
+    size_t changed = 0;
+    const auto* a = original->getData();
+    const auto* b = patched->getData();
+    for (size_t i = 0; i < Raw::FILE_SIZE; ++i)
+    {
+        changed += a[i] != b[i];
+    }
+    EXPECT_LE(changed, 1 + 4 + 3 + 4);
+    EXPECT_EQ(std::memcmp(&before.characters[4], &after.characters[4], sizeof(Raw::Character) * 124), 0);
+
+    fs::remove(tmp_path);
+}
+
+TEST(ScenarioWriter, SaveFileAtomically)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto target = fs::temp_directory_path() / "ScenarioWriter_saved.DAT";
+    fs::remove(target);
+
+    ScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(data_path / "SAVE.DAT"));
+    auto& scenario = file.getScenarios().edit(2);
+    scenario.getCharacters()[7]->setPolitics(88);
+    scenario.getGameData().setTrust(42);
+
+    const auto changes = ScenarioWriter::saveFile(file, target, false);
+    EXPECT_EQ(changes.getRanges().size(), 2);
+    EXPECT_EQ(changes.getByteCount(), sizeof(Raw::Character) + sizeof(Raw::GameData));
+    EXPECT_FALSE(scenario.getCharacters()[7]->isDirty());
+    EXPECT_FALSE(scenario.getGameData().isDirty());
+    EXPECT_FALSE(fs::exists(fs::path(target) += ".tmp"));
+
+    const auto original = RawFileImage::open(data_path / "SAVE.DAT");
+    const auto saved = RawFileImage::open(target);
+    ASSERT_TRUE(original && saved);
+    EXPECT_EQ(saved->getScenario(2).characters[7].politics, 88);
+    EXPECT_EQ(saved->getScenario(2).game_data.trust, 42);
+
+    // 修改范围之外的字节保持不变
+    const auto* a = original->getData();
+    const auto* b = saved->getData();
+    size_t offset = 0;
+    for (const auto& range : changes.getRanges())
+    {
+        EXPECT_EQ(std::memcmp(a + offset, b + offset, range.offset - offset), 0);
+        offset = range.offset + range.length;
+    }
+    EXPECT_EQ(std::memcmp(a + offset, b + offset, Raw::FILE_SIZE - offset), 0);
+
+    // 没有修改时写出加载时的内容
+    EXPECT_TRUE(ScenarioWriter::saveFile(file, target, false).empty());
+    fs::remove(target);
+}
+
+TEST(ScenarioWriter, SaveIgnoresConcurrentDiskChanges)
+{
+    auto data_path = fs::current_path() / "tests";
+    auto path = fs::temp_directory_path() / "ScenarioWriter_stale.DAT";
+    fs::copy_file(data_path / "SAVE.DAT", path, fs::copy_options::overwrite_existing);
+
+    ScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(path));
+    const auto loaded = std::make_unique<Raw::File>(file.getImage()->getFile());
+
+    // 加载之后另一个进程替换了文件
+    auto other = std::make_unique<Raw::File>(*loaded);
+    other->scenarios[0].characters[0].politics ^= 0xff;
+    replace_file_atomically(path, std::span(reinterpret_cast<const uint8_t*>(other.get()), sizeof(Raw::File)), false);
+
+    file.getScenarios().edit(2).getCharacters()[7]->setPolitics(88);
+    ScenarioWriter::saveFile(file, false);
+
+    // 写出的是内存中的映像加上修改，不混入磁盘上的新内容
+    loaded->scenarios[2].characters[7].politics = 88;
+    const auto saved = RawFileImage::open(path);
+    ASSERT_TRUE(saved);
+    EXPECT_EQ(std::memcmp(saved->getData(), loaded.get(), sizeof(Raw::File)), 0);
+    fs::remove(path);
+}
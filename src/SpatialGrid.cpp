@@ -0,0 +1,191 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DragonData
+{
+namespace
+{
+    int64_t distance2(const int64_t x0, const int64_t y0, const int64_t x1, const int64_t y1)
+    {
+        return (x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0);
+    }
+}
+
+SpatialGrid::SpatialGrid(const uint8_t shift)
+    : shift(shift)
+{
+    if (shift == 0 || shift > 15) throw invalid_argument("grid shift must be in [1, 15]");
+}
+
+void SpatialGrid::insert(const uint8_t slot, const uint16_t x, const uint16_t y)
+{
+    const uint32_t cx = x >> shift;
+    const uint32_t cy = y >> shift;
+    cells[key(cx, cy)].push_back({slot, x, y});
+    min_cx = min(min_cx, cx);
+    min_cy = min(min_cy, cy);
+    max_cx = max(max_cx, cx);
+    max_cy = max(max_cy, cy);
+    ++count;
+}
+
+void SpatialGrid::erase(const uint8_t slot, const uint16_t x, const uint16_t y)
+{
+    const auto cell = cells.find(key(x >> shift, y >> shift));
+    if (cell != cells.end())
+    {
+        auto& entries = cell->second;
+        const auto it = find_if(entries.begin(), entries.end(), [&](const Entry& entry)
+        {
+            return entry.slot == slot && entry.x == x && entry.y == y;
+        });
+        if (it != entries.end())
+        {
+            *it = entries.back();
+            entries.pop_back();
+            if (entries.empty()) cells.erase(cell);
+            --count;
+            return;
+        }
+    }
+    throw logic_error("spatial grid out of sync");
+}
+
+void SpatialGrid::move(const uint8_t slot, const uint16_t x, const uint16_t y, const uint16_t new_x,
+                       const uint16_t new_y)
+{
+    erase(slot, x, y);
+    insert(slot, new_x, new_y);
+}
+
+template <typename F>
+void SpatialGrid::forEachCell(uint32_t cx0, uint32_t cy0, uint32_t cx1, uint32_t cy1, F&& f) const
+{
+    cx0 = max(cx0, min_cx);
+    cy0 = max(cy0, min_cy);
+    cx1 = min(cx1, max_cx);
+    cy1 = min(cy1, max_cy);
+    if (count == 0 || cx0 > cx1 || cy0 > cy1) return;
+
+    // 范围比已占用的格子还多时直接遍历格子
+    if (static_cast<size_t>(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > cells.size())
+    {
+        for (const auto& [k, entries] : cells)
+        {
+            const auto cx = k >> 16;
+            const auto cy = k & 0xffff;
+            if (cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1) f(entries);
+        }
+        return;
+    }
+
+    for (auto cx = cx0; cx <= cx1; ++cx)
+    {
+        for (auto cy = cy0; cy <= cy1; ++cy)
+        {
+            if (const auto cell = cells.find(key(cx, cy)); cell != cells.end()) f(cell->second);
+        }
+    }
+}
+
+vector<uint8_t> SpatialGrid::inRect(const uint16_t x0, const uint16_t y0, const uint16_t x1, const uint16_t y1) const
+{
+    vector<uint8_t> result;
+    forEachCell(x0 >> shift, y0 >> shift, x1 >> shift, y1 >> shift, [&](const vector<Entry>& entries)
+    {
+        for (const auto& entry : entries)
+        {
+            if (entry.x >= x0 && entry.x <= x1 && entry.y >= y0 && entry.y <= y1) result.push_back(entry.slot);
+        }
+    });
+    return result;
+}
+
+vector<uint8_t> SpatialGrid::inRadius(const uint16_t x, const uint16_t y, const uint16_t radius) const
+{
+    vector<uint8_t> result;
+    const auto x0 = x > radius ? x - radius : 0;
+    const auto y0 = y > radius ? y - radius : 0;
+    const auto x1 = min<uint32_t>(x + radius, UINT16_MAX);
+    const auto y1 = min<uint32_t>(y + radius, UINT16_MAX);
+    const auto limit = static_cast<int64_t>(radius) * radius;
+    forEachCell(x0 >> shift, y0 >> shift, x1 >> shift, y1 >> shift, [&](const vector<Entry>& entries)
+    {
+        for (const auto& entry : entries)
+        {
+            if (distance2(x, y, entry.x, entry.y) <= limit) result.push_back(entry.slot);
+        }
+    });
+    return result;
+}
+
+optional<uint8_t> SpatialGrid::nearest(const uint16_t x, const uint16_t y) const
+{
+    if (count == 0) return nullopt;
+
+    const int64_t cx = x >> shift;
+    const int64_t cy = y >> shift;
+    const int64_t cell = int64_t{1} << shift;
+    const auto max_ring = max({cx - static_cast<int64_t>(min_cx), static_cast<int64_t>(max_cx) - cx,
+                               cy - static_cast<int64_t>(min_cy), static_cast<int64_t>(max_cy) - cy});
+
+    auto best = numeric_limits<int64_t>::max();
+    uint8_t best_slot = 0;
+    const auto visit_entries = [&](const vector<Entry>& entries)
+    {
+        for (const auto& entry : entries)
+        {
+            const auto d = distance2(x, y, entry.x, entry.y);
+            if (d < best || (d == best && entry.slot < best_slot))
+            {
+                best = d;
+                best_slot = entry.slot;
+            }
+        }
+    };
+    size_t visited = 0;
+    const auto visit = [&](const int64_t i, const int64_t j)
+    {
+        if (i < min_cx || i > max_cx || j < min_cy || j > max_cy) return;
+        ++visited;
+        const auto it = cells.find(key(static_cast<uint32_t>(i), static_cast<uint32_t>(j)));
+        if (it != cells.end()) visit_entries(it->second);
+    };
+
+    // 由内向外逐圈搜索；第 r 圈中的点至少相距 (r - 1) 个格子，已找到更近的点时停止。
+    // 周围空格子很多时，查过的格子数超过已占用的格子数后改为遍历全部格子。
+    for (int64_t r = 0; r <= max_ring; ++r)
+    {
+        if (r > 1 && best <= (r - 1) * cell * (r - 1) * cell) break;
+        if (visited > cells.size())
+        {
+            for (const auto& [k, entries] : cells)
+            {
+                visit_entries(entries);
+            }
+            break;
+        }
+        if (r == 0)
+        {
+            visit(cx, cy);
+            continue;
+        }
+        for (auto i = cx - r; i <= cx + r; ++i)
+        {
+            visit(i, cy - r);
+            visit(i, cy + r);
+        }
+        for (auto j = cy - r + 1; j < cy + r; ++j)
+        {
+            visit(cx - r, j);
+            visit(cx + r, j);
+        }
+    }
+    return best_slot;
+}
+}
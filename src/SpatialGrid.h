@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace DragonData
+{
+// 地图坐标上的均匀网格索引，每个格子为 2^shift × 2^shift，格子中保存原始槽位。
+// 城市与军团的坐标范围不同（军团当前位置的编码方式尚不清楚），各自使用一个网格。
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(uint8_t shift = 4);
+
+    void insert(uint8_t slot, uint16_t x, uint16_t y);
+    // 槽位不在 (x, y) 时抛出 std::logic_error
+    void erase(uint8_t slot, uint16_t x, uint16_t y);
+    void move(uint8_t slot, uint16_t x, uint16_t y, uint16_t new_x, uint16_t new_y);
+
+    [[nodiscard]] size_t size() const
+    {
+        return count;
+    }
+
+    // 矩形 [x0, x1] × [y0, y1]（含边界）内的槽位，顺序不定
+    [[nodiscard]] vector<uint8_t> inRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) const;
+
+    // 与 (x, y) 的欧氏距离不超过 radius 的槽位，顺序不定
+    [[nodiscard]] vector<uint8_t> inRadius(uint16_t x, uint16_t y, uint16_t radius) const;
+
+    // 距离 (x, y) 最近的槽位，距离相同时取槽位较小者；网格为空时返回 nullopt
+    [[nodiscard]] optional<uint8_t> nearest(uint16_t x, uint16_t y) const;
+
+private:
+    struct Entry
+    {
+        uint8_t slot;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    [[nodiscard]] static uint32_t key(const uint32_t cx, const uint32_t cy)
+    {
+        return cx << 16 | cy;
+    }
+
+    // 对 [cx0, cx1] × [cy0, cy1] 中已占用的格子调用 f，范围先与已占用的边界求交
+    template <typename F>
+    void forEachCell(uint32_t cx0, uint32_t cy0, uint32_t cx1, uint32_t cy1, F&& f) const;
+
+    uint8_t shift;
+    size_t count = 0;
+    // 曾经占用过的格子的边界，只会扩大
+    uint32_t min_cx = UINT16_MAX;
+    uint32_t min_cy = UINT16_MAX;
+    uint32_t max_cx = 0;
+    uint32_t max_cy = 0;
+    unordered_map<uint32_t, vector<Entry>> cells;
+};
+}
@@ -0,0 +1,95 @@
+#include "SpatialGrid.h"
+#include "DragonData.h"
+#include "ScenarioWriter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+
+using namespace DragonData;
+namespace fs = std::filesystem;
+
+
+TEST(SpatialGrid, MatchBruteForce)
+{
+    struct Point
+    {
+        uint16_t x;
+        uint16_t y;
+    };
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coord(1, 6000);
+    std::vector<Point> points(128);
+    SpatialGrid grid(6);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        points[i] = {static_cast<uint16_t>(coord(rng)), static_cast<uint16_t>(coord(rng))};
+        grid.insert(static_cast<uint8_t>(i), points[i].x, points[i].y);
+    }
+    // 移动一半的点，索引需要与实际位置一致
+    for (size_t i = 0; i < points.size(); i += 2)
+    {
+        const Point moved{static_cast<uint16_t>(coord(rng)), static_cast<uint16_t>(coord(rng))};
+        grid.move(static_cast<uint8_t>(i), points[i].x, points[i].y, moved.x, moved.y);
+        points[i] = moved;
+    }
+    EXPECT_EQ(grid.size(), points.size());
+    EXPECT_THROW(grid.erase(1, 0, 0), std::logic_error);
+
+    const auto d2 = [](const Point& p, int x, int y) { return (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y); };
+    for (int round = 0; round < 200; ++round)
+    {
+        const auto x = static_cast<uint16_t>(coord(rng));
+        const auto y = static_cast<uint16_t>(coord(rng));
+        const auto radius = static_cast<uint16_t>(coord(rng) / 8);
+
+        std::vector<uint8_t> in_rect, in_radius;
+        size_t nearest = 0;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& p = points[i];
+            if (p.x >= x && p.x <= x + radius && p.y >= y && p.y <= y + radius) in_rect.push_back(i);
+            if (d2(p, x, y) <= radius * radius) in_radius.push_back(i);
+            if (d2(p, x, y) < d2(points[nearest], x, y)) nearest = i;
+        }
+
+        auto rect = grid.inRect(x, y, static_cast<uint16_t>(x + radius), static_cast<uint16_t>(y + radius));
+        auto circle = grid.inRadius(x, y, radius);
+        std::sort(rect.begin(), rect.end());
+        std::sort(circle.begin(), circle.end());
+        EXPECT_EQ(rect, in_rect);
+        EXPECT_EQ(circle, in_radius);
+        EXPECT_EQ(grid.nearest(x, y), nearest);
+    }
+
+    EXPECT_FALSE(SpatialGrid().nearest(10, 10).has_value());
+    EXPECT_TRUE(SpatialGrid().inRect(0, 0, UINT16_MAX, UINT16_MAX).empty());
+    EXPECT_EQ(grid.inRect(0, 0, UINT16_MAX, UINT16_MAX).size(), points.size());
+}
+
+TEST(SpatialGrid, ScenarioGrids)
+{
+    auto data_path = fs::current_path() / "tests";
+    SavedScenarioFile file(LoadMode::Lazy);
+    ASSERT_TRUE(file.loadFile(data_path / "SAVE.DAT"));
+    auto& scenario = file.getScenarios().edit(2);
+    EXPECT_EQ(scenario.getCityGrid().size(), scenario.getCities().size());
+    EXPECT_EQ(scenario.getLegionGrid().size(), scenario.getLegions().size());
+
+    const auto& city = scenario.getCities()[3];
+    EXPECT_EQ(scenario.nearestCity(city->getAxis().x, city->getAxis().y), city.get());
+    const auto near = scenario.getCityGrid().inRadius(city->getAxis().x, city->getAxis().y, 0);
+    EXPECT_NE(std::find(near.begin(), near.end(), city->getIndex()), near.end());
+
+    // 移动军团后网格随之更新，新位置写回文件映像
+    ASSERT_FALSE(scenario.getLegions().empty());
+    const auto& legion = scenario.getLegions().front();
+    legion->setCurrentAxis({5000, 4000});
+    EXPECT_EQ(scenario.getLegionGrid().nearest(5000, 4000), legion->getIndex());
+    EXPECT_EQ(scenario.getLegionGrid().inRect(4990, 3990, 5010, 4010), std::vector<uint8_t>{legion->getIndex()});
+    EXPECT_THROW(legion->setCurrentAxis({0, 10}), std::out_of_range);
+
+    Raw::Legion raw = file.getImage()->getScenario(2).legions[legion->getIndex()];
+    ScenarioWriter::write(*legion, raw);
+    EXPECT_EQ(raw.current_axis.x, 5000);
+    EXPECT_EQ(raw.current_axis.y, 4000);
+}